@@ -20,40 +20,227 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 #pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <defines.h>
+#include <settings.h>
+#include <input_generator.h>
 
 //// INPUT
-int *input_vector = NULL;
+// Read-only for the methods: an int32 input file is used in place through a read-only mapping
+const int *input_vector = NULL;
 size_t input_vector_size = 0;
 
+// Binary input files: an input_file_header_t followed by count samples of the given type
+// (native byte order), e.g. a recording dumped as is from an int32 or float ADC stream.
+#define INPUT_FILE_MAGIC "AVGS"
+
+typedef enum input_type_en
+{
+    INPUT_INT32 = 0,
+    INPUT_FLOAT32 = 1,
+    INPUT_FLOAT64 = 2
+} input_type_t;
+
+typedef struct input_file_header_st
+{
+    char magic[4];  // INPUT_FILE_MAGIC
+    uint32_t type;  // input_type_t of the samples
+    uint64_t count; // number of samples after the header
+} input_file_header_t;
+
+// The mapping of the input file, NULL when the input was generated
+void *input_mapping = NULL;
+size_t input_mapping_size = 0;
+
+// Smallest and largest input samples, computed on the first input_vector_bounds call
+int input_min = 0;
+int input_max = 0;
+int input_bounds_valid = 0;
+
+// Generates size samples of input_distribution from input_seed,
+// on parallel_threads threads (the samples do not depend on the number of threads).
+// Returns 0 (with a message on stderr) when the vector cannot be allocated.
 int init_input_vector(size_t size)
 {
     assert(input_vector == NULL);
-    input_vector = (int *)malloc(size * sizeof(int));
-    input_vector_size = size;
-    for (int i = 0; i < size; ++i)
+    int *samples = (int *)malloc(size * sizeof(int));
+    if (samples == NULL)
+    {
+        fprintf(stderr, "cannot allocate %zu input samples\n", size);
+        return 0;
+    }
+
+    int distribution = generator_distribution(input_distribution);
+    assert(distribution >= 0);
+
+    size_t threads = parallel_threads;
+    if (threads == 0)
     {
-        input_vector[i] = rand() % (1 << 12);
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cores > 0) ? (size_t)cores : 1;
     }
+    generator_fill(samples, size, (generator_distribution_t)distribution, input_seed, threads);
+    input_vector = samples;
+    input_vector_size = size;
+    return 1;
 }
 
 int print_input_vector()
 {
     assert(input_vector != NULL);
     printf("input_vector:");
-    for (int i = 0; i < input_vector_size; ++i)
+    for (size_t i = 0; i < input_vector_size; ++i)
     {
         printf(" %d", input_vector[i]);
     }
     printf("\n");
+    return 0;
+}
+
+// Smallest and largest samples of the input vector (0 and 0 when it is empty).
+// The input never changes once loaded, so it is only scanned once.
+void input_vector_bounds(int *min_value, int *max_value)
+{
+    if (!input_bounds_valid)
+    {
+        input_min = (input_vector_size > 0) ? input_vector[0] : 0;
+        input_max = input_min;
+        for (size_t i = 1; i < input_vector_size; ++i)
+        {
+            if (input_vector[i] < input_min)
+            {
+                input_min = input_vector[i];
+            }
+            if (input_vector[i] > input_max)
+            {
+                input_max = input_vector[i];
+            }
+        }
+        input_bounds_valid = 1;
+    }
+    *min_value = input_min;
+    *max_value = input_max;
+}
+
+// Maps a binary input file read-only as the input vector.
+// int32 samples are used in place (no copy, pages are read on demand, so startup is immediate
+// and files larger than the RAM work), float32/float64 samples are rounded into a heap vector
+// since every method averages int32 samples (a value outside the int32 range, or NaN, rejects the file).
+// Returns 0 (with a message on stderr) when the file cannot be used.
+int map_input_vector(const char *path)
+{
+    assert(input_vector == NULL);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(path);
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(input_file_header_t))
+    {
+        fprintf(stderr, "%s: not an input file (too small)\n", path);
+        close(fd);
+        return 0;
+    }
+
+    // the mapping stays valid after closing the descriptor
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        perror(path);
+        return 0;
+    }
+
+    const input_file_header_t *header = (const input_file_header_t *)mapping;
+    size_t sample_size = (header->type == INPUT_INT32) ? sizeof(int32_t)
+                         : (header->type == INPUT_FLOAT32) ? sizeof(float)
+                         : (header->type == INPUT_FLOAT64) ? sizeof(double)
+                         : 0;
+    size_t available = ((size_t)st.st_size - sizeof(input_file_header_t)) / (sample_size ? sample_size : 1);
+    if (memcmp(header->magic, INPUT_FILE_MAGIC, 4) != 0 || sample_size == 0 || header->count > available)
+    {
+        fprintf(stderr, "%s: bad header or truncated samples\n", path);
+        munmap(mapping, (size_t)st.st_size);
+        return 0;
+    }
+
+    // the methods stream through the input once per run
+    madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    const void *samples = (const char *)mapping + sizeof(input_file_header_t);
+    input_vector_size = (size_t)header->count;
+    if (header->type == INPUT_INT32)
+    {
+        // zero copy, the mapping is read-only and so is input_vector
+        input_vector = (const int *)samples;
+        input_mapping = mapping;
+        input_mapping_size = (size_t)st.st_size;
+        return 1;
+    }
+
+    int *converted = (int *)malloc(input_vector_size * sizeof(int));
+    if (converted == NULL)
+    {
+        fprintf(stderr, "%s: cannot allocate %zu samples\n", path, input_vector_size);
+        munmap(mapping, (size_t)st.st_size);
+        input_vector_size = 0;
+        return 0;
+    }
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        double value = (header->type == INPUT_FLOAT32) ? (double)((const float *)samples)[i]
+                                                       : ((const double *)samples)[i];
+        double rounded = nearbyint(value);
+
+        // the conversion to int is undefined outside its range, NaN compares false
+        if (!(rounded >= (double)INT_MIN && rounded <= (double)INT_MAX))
+        {
+            fprintf(stderr, "%s: sample %zu (%g) is not in the int32 range\n", path, i, value);
+            free(converted);
+            munmap(mapping, (size_t)st.st_size);
+            input_vector_size = 0;
+            return 0;
+        }
+        converted[i] = (int)rounded;
+    }
+    input_vector = converted;
+    munmap(mapping, (size_t)st.st_size);
+    return 1;
 }
 
 int free_input_vector()
 {
     assert(input_vector != NULL);
-    free(input_vector);
+    if (input_mapping != NULL)
+    {
+        // the input points into the file mapping
+        munmap(input_mapping, input_mapping_size);
+        input_mapping = NULL;
+        input_mapping_size = 0;
+    }
+    else
+    {
+        // allocated by init_input_vector or converted by map_input_vector
+        free((void *)input_vector);
+    }
+    input_vector = NULL;
+    input_vector_size = 0;
+    input_bounds_valid = 0;
+    return 0;
 }
 
 /// BUFFER
@@ -63,22 +250,27 @@ size_t buffer_vector_size = 0;
 int init_buffer_vector(size_t size)
 {
     buffer_vector = (int *)calloc(size, sizeof(int));
-    buffer_vector_size = size;
+    buffer_vector_size = (buffer_vector != NULL) ? size : 0;
+    return buffer_vector != NULL;
 }
 
 int print_buffer_vector()
 {
     assert(buffer_vector != NULL);
     printf("buffer_vector:");
-    for (int i = 0; i < buffer_vector_size; ++i)
+    for (size_t i = 0; i < buffer_vector_size; ++i)
     {
         printf(" %d", buffer_vector[i]);
     }
     printf("\n");
+    return 0;
 }
 
 int free_buffer_vector()
 {
     assert(buffer_vector != NULL);
     free(buffer_vector);
+    buffer_vector = NULL;
+    buffer_vector_size = 0;
+    return 0;
 }
\ No newline at end of file
@@ -21,4 +21,18 @@
 // SOFTWARE.
 #pragma once
 #include <vector_avg.h>
-#include <iterative_avg.h>
\ No newline at end of file
+#include <iterative_avg.h>
+#include <batch_avg.h>
+#include <minmax_avg.h>
+#include <variance_avg.h>
+#include <median_avg.h>
+#include <sketch_avg.h>
+#include <multi_window_avg.h>
+#include <bank_avg.h>
+#include <spsc_avg.h>
+#include <parallel_avg.h>
+#include <stream_avg.h>
+#include <ewma_avg.h>
+#include <fir_avg.h>
+#include <mirror_avg.h>
+#include <pyramid_avg.h>
\ No newline at end of file
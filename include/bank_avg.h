@@ -0,0 +1,55 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// The input is read as BANK_CHANNELS interleaved channels (sample t of channel c at t * BANK_CHANNELS + c)
+int main_bank()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int *avg = (int *)malloc(BANK_CHANNELS * sizeof(int)); // averages of every channel
+    bufferi_bank_t b;                                       // bank struct
+    bufferi_bank_init(&b, BANK_CHANNELS, window_size);      // initialize BANK_CHANNELS channels with window_size as maximum size
+
+    for (size_t i = 0; i + BANK_CHANNELS <= input_vector_size; i += BANK_CHANNELS)
+    {
+        bufferi_bank_push(&b, input_vector + i); // O(channels), SIMD
+        bufferi_bank_means(&b, avg);             // O(channels)
+        if (verbose)
+        {
+            printf("avg:");
+            for (size_t c = 0; c < BANK_CHANNELS; ++c)
+            {
+                printf(" %d", avg[c]);
+            }
+            printf("\n");
+        }
+    }
+
+    bufferi_bank_free(&b);
+    free(avg);
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+int main_batch()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int *avg = (int *)malloc(BATCH_SIZE * sizeof(int)); // averages of one block
+    bufferi_t b;                                         // buffer struct
+    bufferi_init_pow2(&b, window_size);                  // initialize buffer with window_size as maximum size (mask indexing)
+
+    for (size_t i = 0; i < input_vector_size; i += BATCH_SIZE)
+    {
+        size_t n = input_vector_size - i;
+        if (n > BATCH_SIZE)
+        {
+            n = BATCH_SIZE;
+        }
+        bufferi_push_many(&b, input_vector + i, n, avg); // O(n) for n averages
+        sink_write(&results, avg, n);
+        if (verbose)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                printf("avg: %d\n", avg[j]);
+            }
+        }
+    }
+
+    bufferi_free(&b);
+    free(avg);
+
+    return 0;
+}
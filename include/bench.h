@@ -0,0 +1,528 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <avg_methods.h>
+#include <perf_counters.h>
+
+// Benchmark harness: every method runs warmup untimed times and then repetitions timed
+// times with CLOCK_MONOTONIC, and is reported as min/median/p99 time, ns per sample
+// and samples per second, as text, CSV or JSON.
+// With -p the hardware counters of the timed runs are reported per sample as well.
+
+typedef struct bench_method_st
+{
+    const char *name;        // command line name
+    int (*run)(void);        // driver
+    int sink;                // the driver outputs its averages to the results sink
+    void (*setup)(void);     // untimed allocations shared by the runs (NULL when none)
+    void (*teardown)(void);  // releases what setup allocated (NULL when none)
+} bench_method_t;
+
+bench_method_t bench_methods[] = {
+    {"iterative", main_iterative, 1, NULL, NULL},
+    {"vector", main_vector, 1, NULL, NULL},
+    {"batch", main_batch, 1, NULL, NULL},
+    {"minmax", main_minmax, 0, NULL, NULL},
+    {"minmax_naive", main_minmax_naive, 0, NULL, NULL},
+    {"variance", main_variance, 0, NULL, NULL},
+    {"variance_naive", main_variance_naive, 0, NULL, NULL},
+    {"median", main_median, 0, NULL, NULL},
+    {"median_skiplist", main_median_skiplist, 0, NULL, NULL},
+    {"sketch", main_sketch, 0, NULL, NULL},
+    {"sketch_accuracy", main_sketch_accuracy, 0, NULL, NULL},
+    {"multi_window", main_multi_window, 0, NULL, NULL},
+    {"bank", main_bank, 0, NULL, NULL},
+    {"spsc", main_spsc, 1, NULL, NULL},
+    {"parallel", main_parallel, 1, parallel_setup, parallel_teardown},
+    {"ewma", main_ewma, 1, NULL, NULL},
+    {"ewma_float", main_ewma_float, 1, NULL, NULL},
+    {"ewma_bank", main_ewma_bank, 0, NULL, NULL},
+    {"fir", main_fir, 1, NULL, NULL},
+    {"fir_block", main_fir_block, 1, NULL, NULL},
+    {"fir_naive", main_fir_naive, 1, NULL, NULL},
+    {"mirror", main_mirror, 1, NULL, NULL},
+    {"pyramid", main_pyramid, 0, NULL, NULL},
+};
+
+#define BENCH_METHODS (sizeof(bench_methods) / sizeof(bench_methods[0]))
+
+typedef enum bench_format_en
+{
+    BENCH_TEXT,
+    BENCH_CSV,
+    BENCH_JSON
+} bench_format_t;
+
+typedef struct bench_options_st
+{
+    const char *methods;   // comma separated method names, or "all"
+    size_t warmup;         // untimed runs per method
+    size_t repetitions;    // timed runs per method
+    bench_format_t format; // report format
+    int counters;          // read hardware performance counters
+    int stream;            // average stdin with main_stream instead of benchmarking the methods
+    const char *output;    // result sink: array, FILE, text:FILE or direct:FILE (NULL discards the averages)
+} bench_options_t;
+
+typedef struct bench_result_st
+{
+    const char *name;       // method name
+    double min_ns;          // fastest run
+    double median_ns;       // median run
+    double p99_ns;          // 99th percentile run (nearest rank)
+    double ns_per_sample;   // median run / input samples
+    double samples_per_sec; // input samples / median run
+    double per_sample[PERF_EVENTS]; // counter values per sample, negative when not counted
+    double ipc;                     // instructions per cycle, negative when not counted
+} bench_result_t;
+
+// Counters shared by every method (see bench_open_counters)
+perf_counters_t bench_counters;
+
+double bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int bench_compare(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void bench_usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -n SAMPLES   input size (default %zu)\n"
+            "  -i FILE      binary input file (int32/float32/float64 samples), instead of -n random samples\n"
+            "  -S SEED      seed of the generated samples (default %llu)\n"
+            "  -d DIST      distribution of the generated samples: uniform, gaussian, step or spike (default uniform)\n"
+            "  -s           average the int32 samples streamed on stdin (e.g. a pipe) until its end\n"
+            "  -w SAMPLES   window size (default %zu)\n"
+            "  -m METHODS   comma separated methods, or all (default all)\n"
+            "  -u RUNS      untimed warm-up runs per method (default 0)\n"
+            "  -r RUNS      timed runs per method (default 1)\n"
+            "  -f FORMAT    text, csv or json (default text)\n"
+            "  -t THREADS   main_parallel and input generator threads, 0 for every core (default %zu)\n"
+            "  -o SINK      keep the averages: array (in memory), FILE (int32 input file), text:FILE or direct:FILE (O_DIRECT)\n"
+            "               of the last selected method that outputs them (not the statistics methods)\n"
+            "  -p           report hardware performance counters per sample\n"
+            "  -v / -q      print / do not print every window and average\n"
+            "methods:",
+            program, input_size, input_seed, window_size, parallel_threads);
+    for (size_t m = 0; m < BENCH_METHODS; ++m)
+    {
+        fprintf(stderr, " %s", bench_methods[m].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+// Parses the command line into the settings and o, returns 0 on invalid options
+int bench_parse(int argc, char **argv, bench_options_t *o)
+{
+    o->methods = "all";
+    o->warmup = 0;
+    o->repetitions = 1;
+    o->format = BENCH_TEXT;
+    o->counters = 0;
+    o->stream = 0;
+    o->output = NULL;
+
+    int c;
+    while ((c = getopt(argc, argv, "n:i:S:d:sw:m:u:r:f:t:o:pvqh")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            input_size = strtoull(optarg, NULL, 0);
+            break;
+        case 'i':
+            input_path = optarg;
+            break;
+        case 'S':
+            input_seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'd':
+            if (generator_distribution(optarg) < 0)
+            {
+                return 0;
+            }
+            input_distribution = optarg;
+            break;
+        case 's':
+            o->stream = 1;
+            break;
+        case 'w':
+            window_size = strtoull(optarg, NULL, 0);
+            break;
+        case 'm':
+            o->methods = optarg;
+            break;
+        case 'u':
+            o->warmup = strtoull(optarg, NULL, 0);
+            break;
+        case 'r':
+            o->repetitions = strtoull(optarg, NULL, 0);
+            break;
+        case 'f':
+            if (strcmp(optarg, "text") == 0)
+            {
+                o->format = BENCH_TEXT;
+            }
+            else if (strcmp(optarg, "csv") == 0)
+            {
+                o->format = BENCH_CSV;
+            }
+            else if (strcmp(optarg, "json") == 0)
+            {
+                o->format = BENCH_JSON;
+            }
+            else
+            {
+                return 0;
+            }
+            break;
+        case 't':
+            parallel_threads = strtoull(optarg, NULL, 0);
+            break;
+        case 'o':
+            o->output = optarg;
+            break;
+        case 'p':
+            o->counters = 1;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'q':
+            verbose = 0;
+            break;
+        default:
+            return 0;
+        }
+    }
+
+    return window_size > 0 && o->repetitions > 0;
+}
+
+// Whether name is selected by the comma separated list
+int bench_selected(const char *list, const char *name)
+{
+    if (strcmp(list, "all") == 0)
+    {
+        return 1;
+    }
+
+    size_t length = strlen(name);
+    for (const char *p = list; p != NULL; p = strchr(p, ','))
+    {
+        if (*p == ',')
+        {
+            p++;
+        }
+        if (strncmp(p, name, length) == 0 && (p[length] == ',' || p[length] == '\0'))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Opens the hardware counters when requested, falls back to timing only when
+// perf events are not permitted, returns whether counters will be reported
+int bench_open_counters(bench_options_t *o)
+{
+    if (!o->counters)
+    {
+        return 0;
+    }
+
+    if (perf_counters_open(&bench_counters) == 0)
+    {
+        fprintf(stderr, "perf events are not available (see /proc/sys/kernel/perf_event_paranoid), "
+                        "reporting timings only\n");
+        o->counters = 0;
+        return 0;
+    }
+
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        if (!perf_counters_has(&bench_counters, (perf_event_t)e))
+        {
+            fprintf(stderr, "perf event %s is not available\n", perf_event_names[e]);
+        }
+    }
+    return 1;
+}
+
+void bench_close_counters(bench_options_t *o)
+{
+    if (o->counters)
+    {
+        perf_counters_close(&bench_counters);
+    }
+}
+
+// Opens the result sink of -o (once the input size is known), returns 0 on failure
+int bench_open_sink(const bench_options_t *o)
+{
+    if (o->output == NULL)
+    {
+        return 1;
+    }
+    if (strcmp(o->output, "array") == 0)
+    {
+        return sink_open_array(&results, input_vector_size);
+    }
+    if (strncmp(o->output, "text:", 5) == 0)
+    {
+        return sink_open_file(&results, o->output + 5, SINK_TEXT, 0);
+    }
+    if (strncmp(o->output, "direct:", 7) == 0)
+    {
+        return sink_open_file(&results, o->output + 7, SINK_BINARY, 1);
+    }
+    return sink_open_file(&results, o->output, SINK_BINARY, 0);
+}
+
+void bench_close_sink(const bench_options_t *o)
+{
+    if (o->output == NULL)
+    {
+        return;
+    }
+    if (results.error != 0)
+    {
+        fprintf(stderr, "%s: %s\n", o->output, strerror(results.error));
+    }
+    fprintf(stderr, "results: %zu averages of the last run", results.count);
+    if (results.fd >= 0)
+    {
+        fprintf(stderr, ", %zu bytes written", results.written);
+    }
+    fprintf(stderr, "\n");
+    sink_close(&results);
+}
+
+// Runs a method and fills r, returns 0 (with a message on stderr) when the timings cannot be allocated
+int bench_run(const bench_method_t *m, const bench_options_t *o, bench_result_t *r)
+{
+    double *times = (o->repetitions <= SIZE_MAX / sizeof(double))
+                        ? (double *)malloc(o->repetitions * sizeof(double))
+                        : NULL;
+    if (times == NULL)
+    {
+        fprintf(stderr, "cannot allocate the timings of %zu repetitions\n", o->repetitions);
+        return 0;
+    }
+
+    // outside the timed region, the runs reuse what it allocates
+    if (m->setup != NULL)
+    {
+        m->setup();
+    }
+
+    // a method without output leaves the sink (and the averages of the previous method) alone
+    for (size_t i = 0; i < o->warmup; ++i)
+    {
+        if (m->sink)
+        {
+            sink_begin(&results);
+        }
+        m->run();
+        if (m->sink)
+        {
+            sink_end(&results);
+        }
+    }
+    if (o->counters)
+    {
+        perf_counters_reset(&bench_counters);
+    }
+    for (size_t i = 0; i < o->repetitions; ++i)
+    {
+        // the counters are enabled just outside the timed region,
+        // the output of the averages is part of it
+        if (m->sink)
+        {
+            sink_begin(&results);
+        }
+        if (o->counters)
+        {
+            perf_counters_start(&bench_counters);
+        }
+        double begin = bench_now_ns();
+        m->run();
+        if (m->sink)
+        {
+            sink_end(&results);
+        }
+        times[i] = bench_now_ns() - begin;
+        if (o->counters)
+        {
+            perf_counters_stop(&bench_counters);
+        }
+    }
+
+    qsort(times, o->repetitions, sizeof(double), bench_compare);
+    r->name = m->name;
+    r->min_ns = times[0];
+    r->median_ns = times[(o->repetitions - 1) / 2];
+    r->p99_ns = times[order_rank(0.99, o->repetitions)];
+    r->ns_per_sample = (input_vector_size > 0) ? r->median_ns / (double)input_vector_size : 0.0;
+    r->samples_per_sec = (r->median_ns > 0.0) ? (double)input_vector_size * 1e9 / r->median_ns : 0.0;
+
+    double samples = (double)input_vector_size * (double)o->repetitions;
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        int counted = o->counters && perf_counters_has(&bench_counters, (perf_event_t)e) && samples > 0.0;
+        r->per_sample[e] = counted ? bench_counters.value[e] / samples : -1.0;
+    }
+    r->ipc = -1.0;
+    if (r->per_sample[PERF_CYCLES] > 0.0 && r->per_sample[PERF_INSTRUCTIONS] >= 0.0)
+    {
+        r->ipc = r->per_sample[PERF_INSTRUCTIONS] / r->per_sample[PERF_CYCLES];
+    }
+
+    if (m->teardown != NULL)
+    {
+        m->teardown();
+    }
+    free(times);
+    return 1;
+}
+
+void bench_report_header(const bench_options_t *o)
+{
+    if (o->format == BENCH_CSV)
+    {
+        printf("method,input_size,window_size,repetitions,min_ns,median_ns,p99_ns,ns_per_sample,samples_per_sec");
+        if (o->counters)
+        {
+            for (int e = 0; e < PERF_EVENTS; ++e)
+            {
+                printf(",%s_per_sample", perf_event_names[e]);
+            }
+            printf(",ipc");
+        }
+        printf("\n");
+    }
+    else if (o->format == BENCH_JSON)
+    {
+        printf("[");
+    }
+}
+
+// A counter value, empty in CSV and null in JSON when it was not counted
+void bench_report_counter(const bench_options_t *o, const char *name, double value)
+{
+    switch (o->format)
+    {
+    case BENCH_TEXT:
+        if (value >= 0.0)
+        {
+            printf(" %s %.4lf", name, value);
+        }
+        else
+        {
+            printf(" %s n/a", name);
+        }
+        break;
+    case BENCH_CSV:
+        if (value >= 0.0)
+        {
+            printf(",%.4lf", value);
+        }
+        else
+        {
+            printf(",");
+        }
+        break;
+    case BENCH_JSON:
+        if (value >= 0.0)
+        {
+            printf(", \"%s\": %.4lf", name, value);
+        }
+        else
+        {
+            printf(", \"%s\": null", name);
+        }
+        break;
+    }
+}
+
+void bench_report(const bench_options_t *o, const bench_result_t *r, int first)
+{
+    switch (o->format)
+    {
+    case BENCH_TEXT:
+        printf("%s averaging: min %.3lf ms median %.3lf ms p99 %.3lf ms, %.3lf ns/sample, %.0lf samples/s",
+               r->name, r->min_ns * 1e-6, r->median_ns * 1e-6, r->p99_ns * 1e-6, r->ns_per_sample, r->samples_per_sec);
+        if (o->counters)
+        {
+            printf("\n    per sample:");
+        }
+        break;
+    case BENCH_CSV:
+        printf("%s,%zu,%zu,%zu,%.0lf,%.0lf,%.0lf,%.4lf,%.0lf", r->name, input_vector_size, window_size,
+               o->repetitions, r->min_ns, r->median_ns, r->p99_ns, r->ns_per_sample, r->samples_per_sec);
+        break;
+    case BENCH_JSON:
+        printf("%s\n  {\"method\": \"%s\", \"input_size\": %zu, \"window_size\": %zu, \"repetitions\": %zu, "
+               "\"min_ns\": %.0lf, \"median_ns\": %.0lf, \"p99_ns\": %.0lf, \"ns_per_sample\": %.4lf, \"samples_per_sec\": %.0lf",
+               first ? "" : ",", r->name, input_vector_size, window_size, o->repetitions, r->min_ns, r->median_ns,
+               r->p99_ns, r->ns_per_sample, r->samples_per_sec);
+        break;
+    }
+
+    if (o->counters)
+    {
+        for (int e = 0; e < PERF_EVENTS; ++e)
+        {
+            bench_report_counter(o, perf_event_names[e], r->per_sample[e]);
+        }
+        bench_report_counter(o, "ipc", r->ipc);
+    }
+
+    printf((o->format == BENCH_JSON) ? "}" : "\n");
+    fflush(stdout);
+}
+
+void bench_report_footer(const bench_options_t *o)
+{
+    if (o->format == BENCH_JSON)
+    {
+        printf("\n]\n");
+    }
+}
@@ -0,0 +1,225 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <simd_kernels.h>
+#include <divisor.h>
+
+// Bank of many independent channels with the same window size, stored in one aligned slab.
+// The slab has max_size rows of channels samples (row r holds sample r of every channel),
+// so pushing one sample to every channel touches a single contiguous row.
+// All channels advance in lockstep, so the cursor and size are shared and only the
+// per-channel state (the running sums) is kept as an array.
+
+// Slab alignment and row padding, in bytes (one cache line)
+#define BANK_ALIGNMENT 64
+
+typedef struct bufferi_bank_st
+{
+    int *data;         // window slab, max_size rows of stride samples
+    size_t channels;   // number of channels
+    size_t stride;     // row length, channels rounded up to a cache line
+    size_t max_size;   // window size of every channel
+    size_t size;       // samples in every window
+    size_t cur;        // row of the oldest samples
+    long long *sums;   // running sum of each channel
+    divisor_t divisor; // max_size divisor, for the full window averages
+} bufferi_bank_t;
+
+// Clears every channel, the slab is zeroed so the first rows can be replaced
+// like any other (a zero leaves the running sums untouched)
+void bufferi_bank_clear(bufferi_bank_t *b)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+#endif
+
+    if (b->data != NULL)
+    {
+        memset(b->data, 0, b->max_size * b->stride * sizeof(int));
+        memset(b->sums, 0, b->channels * sizeof(long long));
+    }
+    b->size = 0;
+    b->cur = 0;
+}
+
+void bufferi_bank_init(bufferi_bank_t *b, size_t channels, size_t max_size)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+#endif
+
+    const size_t line = BANK_ALIGNMENT / sizeof(int);
+    size_t stride = (channels + line - 1) / line * line;
+
+    // allocate the slab and the sums (sizes are multiples of the alignment)
+    b->data = (int *)aligned_alloc(BANK_ALIGNMENT, max_size * stride * sizeof(int));
+    b->sums = (long long *)aligned_alloc(BANK_ALIGNMENT, stride * sizeof(long long));
+
+    // check if data allocation was successful
+    if (b->data != NULL && b->sums != NULL)
+    {
+        // setting up a valid geometry after checking allocation
+        b->channels = channels;
+        b->stride = stride;
+        b->max_size = max_size;
+    }
+    else
+    {
+        // setting up a valid geometry after failing allocation
+        free(b->data);
+        free(b->sums);
+        b->data = NULL;
+        b->sums = NULL;
+        b->channels = 0;
+        b->stride = 0;
+        b->max_size = 0;
+    }
+
+    divisor_init(&b->divisor, b->max_size);
+
+    // initializing slab, sums, size and cur as 0
+    bufferi_bank_clear(b);
+}
+
+void bufferi_bank_free(bufferi_bank_t *b)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+
+    // check if data is allocated before trying to deallocate
+    assert(b->data != NULL);
+#endif
+
+    free(b->data);
+    free(b->sums);
+
+    // just making sure the previous pointers are invalid
+    b->data = NULL;
+    b->sums = NULL;
+    b->channels = 0;
+    b->stride = 0;
+    b->max_size = 0;
+    b->size = 0;
+    b->cur = 0;
+}
+
+// Pushes samples[c] into every channel c (evicting the oldest sample once the windows are full)
+void bufferi_bank_push(bufferi_bank_t *b, const int *samples)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+
+    // check if bank has data
+    assert(b->data != NULL);
+#endif
+
+    // the row after the newest samples is the oldest one once the windows are full
+    // (and a zeroed one before that)
+    size_t row = b->cur + b->size;
+    if (row >= b->max_size)
+    {
+        row -= b->max_size;
+    }
+
+    // one SIMD pass: sums += samples - row, row = samples
+    simd_replacei(b->sums, b->data + row * b->stride, samples, b->channels);
+
+    if (b->size < b->max_size)
+    {
+        b->size++;
+    }
+    else
+    {
+        b->cur = (b->cur + 1 == b->max_size) ? 0 : b->cur + 1;
+    }
+}
+
+// Sample pos (0 is the oldest) of channel c
+int bufferi_bank_get(bufferi_bank_t *b, size_t c, size_t pos)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+
+    // check if channel and position are valid
+    assert(c < b->channels && pos < b->size);
+#endif
+
+    size_t row = b->cur + pos;
+    if (row >= b->max_size)
+    {
+        row -= b->max_size;
+    }
+    return b->data[row * b->stride + c];
+}
+
+// Average of channel c in O(1)
+int bufferi_bank_mean(bufferi_bank_t *b, size_t c)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+
+    // check if channel is valid and not empty
+    assert(c < b->channels && b->size > 0);
+#endif
+
+    if (b->size == b->max_size)
+    {
+        return (int)divisor_divide(&b->divisor, b->sums[c]);
+    }
+    return (int)(b->sums[c] / (long long)b->size);
+}
+
+// Averages of every channel in avg_out[0..channels)
+void bufferi_bank_means(bufferi_bank_t *b, int *avg_out)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+
+    // check if bank is not empty
+    assert(b->size > 0);
+#endif
+
+    if (b->size == b->max_size)
+    {
+        // full windows: a multiply-shift per channel instead of a division
+        for (size_t c = 0; c < b->channels; ++c)
+        {
+            avg_out[c] = (int)divisor_divide(&b->divisor, b->sums[c]);
+        }
+        return;
+    }
+
+    const long long n = (long long)b->size;
+    for (size_t c = 0; c < b->channels; ++c)
+    {
+        avg_out[c] = (int)(b->sums[c] / n);
+    }
+}
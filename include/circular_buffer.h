@@ -20,741 +20,1568 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 #pragma once
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <simd_kernels.h>
+#include <divisor.h>
 
 // Only use this if you know what you are doing!!!
 // #define NO_ASSERT
 
+// Disables the running sum kept inside the buffers,
+// buffer*_sum and buffer*_mean will then scan the whole window.
+// #define NO_RUNNING_SUM
 
-/******************************************************************************************
- *                                                                                        *
- *                                  INT32 VALUES                                          *
- *                                                                                        *
- ******************************************************************************************/
-typedef struct bufferi_st
-{
-    int *data;       // buffer data pointer
-    size_t max_size; // maximum circular buffer size
-    size_t size;     // circular buffer size
-    size_t cur;      // cursor position
-} bufferi_t;
-
-// If you want a memory deallocation look for bufferi_free(bufferi_t *b).
-// This is just a quick clear, without writing zeros, the data is still available.
-void bufferi_clear(bufferi_t *b)
-{
+// Checks and running sum updates usable inside the generated functions (see CIRCULAR_DEFINE)
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+#define CIRCULAR_ASSERT(x) assert(x)
+#else
+#define CIRCULAR_ASSERT(x)
 #endif
 
-    // initializing size as 0
-    b->size = 0;
-
-    // initializing cursor as 0
-    b->cur = 0;
-}
-
-void bufferi_init(bufferi_t *b, size_t max_size)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+#ifndef NO_RUNNING_SUM
+#define CIRCULAR_RUNNING(x) x
+#define CIRCULAR_SUM(running, scan) (running)
+#else
+#define CIRCULAR_RUNNING(x)
+#define CIRCULAR_SUM(running, scan) (scan)
 #endif
 
-    // allocate the requested size
-    b->data = (int *)malloc(max_size * sizeof(int));
+// Number of elements the batch functions process per block (stack scratch size)
+#define CIRCULAR_BLOCK 256
 
-    // check if data allocation was successful
-    if (b->data != NULL)
-    {
-        // setting up a valid max_size after checking allocation
-        b->max_size = max_size;
-    }
-    else
-    {
-        // setting up a valid max_size after failing allocation
-        b->max_size = 0;
-    }
-
-    // initializing size and cur as 0
-    bufferi_clear(b);
-}
-
-void bufferi_free(bufferi_t *b)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if data is allocated before trying to deallocate
-    assert(b->data != NULL);
-#endif
+// Number of samples between exact recomputations of the windowed variance
+// (bounds the rounding drift of the incremental updates), 0 disables it
+#define CIRCULAR_VARIANCE_RESYNC (1 << 20)
 
-    // free data
-    free(b->data);
-
-    // just making sure the previous pointer is invalid
-    b->data = NULL;
-
-    // making sure the max_size verifications will be coherent
-    b->max_size = 0;
-
-    // making sure the size and cur verifications will be coherent
-    bufferi_clear(b);
-}
-
-int *bufferi_at(bufferi_t *b, size_t pos)
+// Smallest power of two greater or equal to n (n = 0 gives 1)
+size_t circular_next_pow2(size_t n)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if buffer has data
-    assert(b->data != NULL);
-#endif
-
-    size_t circular_pos = (pos + b->cur) % b->max_size;
-
-    // check if position is valid in buffer data
-    // assert(circular_pos > -1 && circular_pos < b->max_size);
-
-    // return pointer to circular position in buffer data
-    return &(b->data[circular_pos]);
-}
-
-int bufferi_get(bufferi_t *b, size_t pos)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if buffer has data
-    assert(b->data != NULL);
-
-    // check if position is valid
-    assert((pos >= 0) && (pos < b->size));
-#endif
-
-    // return value from circular position in buffer data
-    return *bufferi_at(b, pos);
-}
-
-void bufferi_push_back(bufferi_t *b, int value)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if circular buffer is not full
-    assert(b->size < b->max_size);
-#endif
-
-    // get possible position for new value
-    int *data = bufferi_at(b, b->size);
-
-    // set data with value
-    *data = value;
-
-    // increment the circular buffer size
-    b->size++;
+    size_t p = 1;
+    while (p < n)
+    {
+        p <<= 1;
+    }
+    return p;
 }
 
-void bufferi_pop_front(bufferi_t *b, int *value)
+// Smallest power of two capacity >= capacity whose values of size bytes fill whole pages
+// (the mapping granularity), 0 when the page size is unknown. Doubling always gets there,
+// the page size is a power of two.
+size_t circular_mirror_capacity(size_t capacity, size_t size)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if circular buffer is not empty
-    assert(b->size > 0);
-#endif
-
-    // get possible position for first value
-    int *data = bufferi_at(b, 0);
-
-    // sets value from first element in the circular buffer
-    if (value != NULL)
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0 || size == 0)
     {
-        *value = *data;
+        return 0;
     }
-
-    // decrement the circular buffer size
-    b->size--;
-
-    // move buffer cursor
-    b->cur = (b->cur + 1) % b->max_size;
+    while (capacity * size < (size_t)page || (capacity * size) % (size_t)page != 0)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
 }
 
-void bufferi_print(bufferi_t *b)
+// Maps the same bytes of an anonymous memory file twice, back to back:
+// base[i] and base[bytes + i] are the same memory. NULL when it is not possible.
+void *circular_mirror_map(size_t bytes)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
+#ifdef MFD_CLOEXEC
+    int fd = memfd_create("circular_buffer", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
 
-    printf("bufferi:");
-    for (size_t p = 0; p < b->size; ++p)
+    // reserve both views at once, then map the file over each half
+    char *base = (char *)mmap(NULL, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
     {
-        printf(" %d", bufferi_get(b, p));
+        close(fd);
+        return NULL;
+    }
+    if (mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(base, 2 * bytes);
+        close(fd);
+        return NULL;
     }
-    printf("\n");
-}
 
-void bufferi_push_and_pop(bufferi_t *b, int push_value, int *pop_value)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+    // the mappings keep the file alive
+    close(fd);
+    return base;
+#else
+    (void)bytes;
+    return NULL;
 #endif
-
-    // pop front before overflowing
-    bufferi_pop_front(b, pop_value);
-
-    // push back after removing first element
-    bufferi_push_back(b, push_value);
 }
 
-void bufferi_avgi(bufferi_t *b, int *avg)
+void circular_mirror_unmap(void *base, size_t bytes)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
-
-    int acc = 0;
-    for (size_t p = 0; p < b->size; ++p)
-    {
-        acc += bufferi_get(b, p);
-    }
-    *avg = acc / b->size;
+    munmap(base, 2 * bytes);
 }
 
-void bufferi_avgd(bufferi_t *b, double *avg)
+// Reverses the elements [begin, end) of data, elements of size bytes
+void circular_reverse(void *data, size_t begin, size_t end, size_t size)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
-
-    double acc = 0.0;
-    for (size_t p = 0; p < b->size; ++p)
+    char *p = (char *)data;
+    char tmp[16];
+    while (end > begin + 1)
     {
-        acc += (double)bufferi_get(b, p);
+        end--;
+        memcpy(tmp, p + begin * size, size);
+        memcpy(p + begin * size, p + end * size, size);
+        memcpy(p + end * size, tmp, size);
+        begin++;
     }
-    *avg = acc / ((double)b->size);
 }
 
-void bufferi_avgf(bufferi_t *b, float *avg)
+// Compensated (Neumaier) accumulation of value into sum, the lost low order bits go to comp
+void circular_compensated_add(double *sum, double *comp, double value)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
-
-    float acc = 0.0f;
-    for (size_t p = 0; p < b->size; ++p)
+    double t = *sum + value;
+    if (fabs(*sum) >= fabs(value))
+    {
+        *comp += (*sum - t) + value;
+    }
+    else
     {
-        acc += (float)bufferi_get(b, p);
+        *comp += (value - t) + *sum;
     }
-    *avg = acc / ((float)b->size);
+    *sum = t;
 }
 
 
 /******************************************************************************************
  *                                                                                        *
- *                                  DOUBLE VALUES                                         *
+ *                                  ELEMENT TRAITS                                        *
  *                                                                                        *
  ******************************************************************************************/
 
-typedef struct bufferd_st
+// Everything CIRCULAR_DEFINE needs to know about an element type T, named circular_T_*:
+// the running sum type, how a value enters (add) and leaves (sub) the running sum,
+// the sum of a contiguous span, the average of a sum (div, or divide by a precomputed divisor_t),
+// the print format and the steady state of push_many (slide).
+// Writing these for another traits name K is enough to generate buffers of its type,
+// CIRCULAR_DEFINE_INTEGER_TRAITS(K, T, FMT) and CIRCULAR_DEFINE_FLOATING_TRAITS(K, T, FMT) write a default set
+// (plain scalar loops, exact long long sums or compensated double sums, FMT the printf conversion of T),
+// see the short, ushort and uint traits at the end of this section.
+
+typedef long long circular_int_sum_t;
+
+void circular_int_add(long long *sum, long long *comp, int value)
 {
-    double *data;    // buffer data pointer
-    size_t max_size; // maximum circular buffer size
-    size_t size;     // circular buffer size
-    size_t cur;      // cursor position
-} bufferd_t;
+    // integer sums are exact, comp stays 0
+    (void)comp;
+    *sum += value;
+}
 
-// If you want a memory deallocation look for bufferd_free(bufferd_t *b).
-// This is just a quick clear, without writing zeros, the data is still available.
-void bufferd_clear(bufferd_t *b)
+void circular_int_sub(long long *sum, long long *comp, int value)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
+    (void)comp;
+    *sum -= value;
+}
 
-    // initializing size as 0
-    b->size = 0;
+long long circular_int_span(const int *src, size_t n)
+{
+    return simd_sumi(src, n);
+}
 
-    // initializing cursor as 0
-    b->cur = 0;
+// Truncated like the integer division
+int circular_int_div(long long sum, size_t n)
+{
+    return (int)(sum / (long long)n);
 }
 
-void bufferd_init(bufferd_t *b, size_t max_size)
+// Same as circular_int_div, with a multiply-shift instead of the division
+int circular_int_divide(long long sum, const divisor_t *v)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
+    return (int)divisor_divide(v, sum);
+}
 
-    // allocate the requested size
-    b->data = (double *)malloc(max_size * sizeof(double));
+void circular_int_print(int value)
+{
+    printf(" %d", value);
+}
 
-    // check if data allocation was successful
-    if (b->data != NULL)
-    {
-        // setting up a valid max_size after checking allocation
-        b->max_size = max_size;
-    }
-    else
+// Writes in avg_out[i] the average of the w = v->d values ending at src[i], given the sum of the w values
+// before src[0] (src[-w] to src[-1] must be readable): sum[i] = sum[i - 1] + (src[i] - src[i - w])
+void circular_int_slide(long long *sum, long long *comp, const int *src, const divisor_t *v, int *avg_out, size_t n)
+{
+    (void)comp;
+    size_t w = v->d;
+    long long acc = *sum;
+    long long diff[CIRCULAR_BLOCK];
+    for (size_t i = 0; i < n;)
     {
-        // setting up a valid max_size after failing allocation
-        b->max_size = 0;
+        size_t block = (n - i < CIRCULAR_BLOCK) ? n - i : CIRCULAR_BLOCK;
+        simd_diffi(src + i, src + i - w, diff, block);
+        for (size_t j = 0; j < block; ++j)
+        {
+            acc += diff[j];
+            avg_out[i + j] = (int)divisor_divide(v, acc);
+        }
+        i += block;
     }
-
-    // initializing size and cur as 0
-    bufferd_clear(b);
+    *sum = acc;
 }
 
-void bufferd_free(bufferd_t *b)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if data is allocated before trying to deallocate
-    assert(b->data != NULL);
-#endif
-
-    // free data
-    free(b->data);
-
-    // just making sure the previous pointer is invalid
-    b->data = NULL;
-
-    // making sure the max_size verifications will be coherent
-    b->max_size = 0;
+typedef double circular_double_sum_t;
 
-    // making sure the size and cur verifications will be coherent
-    bufferd_clear(b);
+void circular_double_add(double *sum, double *comp, double value)
+{
+    circular_compensated_add(sum, comp, value);
 }
 
-double *bufferd_at(bufferd_t *b, size_t pos)
+void circular_double_sub(double *sum, double *comp, double value)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if buffer has data
-    assert(b->data != NULL);
-#endif
-
-    size_t circular_pos = (pos + b->cur) % b->max_size;
-
-    // check if position is valid in buffer data
-    // assert(circular_pos > -1 && circular_pos < b->max_size);
-
-    // return pointer to circular position in buffer data
-    return &(b->data[circular_pos]);
+    circular_compensated_add(sum, comp, -value);
 }
 
-double bufferd_get(bufferd_t *b, size_t pos)
+double circular_double_span(const double *src, size_t n)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if buffer has data
-    assert(b->data != NULL);
-
-    // check if position is valid
-    assert((pos >= 0) && (pos < b->size));
-#endif
-
-    // return value from circular position in buffer data
-    return *bufferd_at(b, pos);
+    return simd_sumd(src, n);
 }
 
-void bufferd_push_back(bufferd_t *b, double value)
+double circular_double_div(double sum, size_t n)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if circular buffer is not full
-    assert(b->size < b->max_size);
-#endif
-
-    // get possible position for new value
-    double *data = bufferd_at(b, b->size);
-
-    // set data with value
-    *data = value;
-
-    // increment the circular buffer size
-    b->size++;
+    return sum / (double)n;
 }
 
-void bufferd_pop_front(bufferd_t *b, double *value)
+double circular_double_divide(double sum, const divisor_t *v)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if circular buffer is not empty
-    assert(b->size > 0);
-#endif
+    return divisor_scale(v, sum);
+}
 
-    // get possible position for first value
-    double *data = bufferd_at(b, 0);
+void circular_double_print(double value)
+{
+    printf(" %lf", value);
+}
 
-    // sets value from first element in the circular buffer
-    if (value != NULL)
+// Same as circular_int_slide, the sums of a block are scaled by the reciprocal together
+void circular_double_slide(double *sum, double *comp, const double *src, const divisor_t *v, double *avg_out, size_t n)
+{
+    size_t w = v->d;
+    double sums[CIRCULAR_BLOCK];
+    for (size_t i = 0; i < n;)
     {
-        *value = *data;
+        size_t block = (n - i < CIRCULAR_BLOCK) ? n - i : CIRCULAR_BLOCK;
+        for (size_t j = 0; j < block; ++j)
+        {
+            circular_compensated_add(sum, comp, src[i + j]);
+            circular_compensated_add(sum, comp, -src[i + j - w]);
+            sums[j] = *sum + *comp;
+        }
+        simd_muld(sums, v->reciprocal, avg_out + i, block);
+        i += block;
     }
+}
 
-    // decrement the circular buffer size
-    b->size--;
+// float samples are summed in double
+typedef double circular_float_sum_t;
 
-    // move buffer cursor
-    b->cur = (b->cur + 1) % b->max_size;
+void circular_float_add(double *sum, double *comp, float value)
+{
+    circular_compensated_add(sum, comp, value);
 }
 
-void bufferd_print(bufferd_t *b)
+void circular_float_sub(double *sum, double *comp, float value)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
-
-    printf("bufferd:");
-    for (size_t p = 0; p < b->size; ++p)
-    {
-        printf(" %lf", bufferd_get(b, p));
-    }
-    printf("\n");
+    circular_compensated_add(sum, comp, -(double)value);
 }
 
-void bufferd_push_and_pop(bufferd_t *b, double push_value, double *pop_value)
+double circular_float_span(const float *src, size_t n)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
-
-    // pop front before overflowing
-    bufferd_pop_front(b, pop_value);
-
-    // push back after removing first element
-    bufferd_push_back(b, push_value);
+    return (double)simd_sumf(src, n);
 }
 
-void bufferd_avgi(bufferd_t *b, int *avg)
+float circular_float_div(double sum, size_t n)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
-
-    int acc = 0;
-    for (size_t p = 0; p < b->size; ++p)
-    {
-        acc += (int)bufferd_get(b, p);
-    }
-    *avg = acc / b->size;
+    return (float)(sum / (double)n);
 }
 
-void bufferd_avgd(bufferd_t *b, double *avg)
+float circular_float_divide(double sum, const divisor_t *v)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+    return (float)divisor_scale(v, sum);
+}
 
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
+void circular_float_print(float value)
+{
+    printf(" %f", value);
+}
 
-    double acc = 0.0;
-    for (size_t p = 0; p < b->size; ++p)
+// Same as circular_double_slide, with float averages
+void circular_float_slide(double *sum, double *comp, const float *src, const divisor_t *v, float *avg_out, size_t n)
+{
+    size_t w = v->d;
+    double sums[CIRCULAR_BLOCK];
+    for (size_t i = 0; i < n;)
     {
-        acc += (double)bufferd_get(b, p);
+        size_t block = (n - i < CIRCULAR_BLOCK) ? n - i : CIRCULAR_BLOCK;
+        for (size_t j = 0; j < block; ++j)
+        {
+            circular_compensated_add(sum, comp, src[i + j]);
+            circular_compensated_add(sum, comp, -(double)src[i + j - w]);
+            sums[j] = *sum + *comp;
+        }
+        simd_muld_f(sums, v->reciprocal, avg_out + i, block);
+        i += block;
     }
-    *avg = acc / ((double)b->size);
 }
 
-void bufferd_avgf(bufferd_t *b, float *avg)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
+// Default traits of an integer type T narrower than long long (the sums are exact long long)
+#define CIRCULAR_DEFINE_INTEGER_TRAITS(K, T, FMT)                                                              \
+typedef long long circular_##K##_sum_t;                                                                        \
+                                                                                                               \
+void circular_##K##_add(long long *sum, long long *comp, T value)                                              \
+{                                                                                                              \
+    /* integer sums are exact, comp stays 0 */                                                                 \
+    (void)comp;                                                                                                \
+    *sum += (long long)value;                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+void circular_##K##_sub(long long *sum, long long *comp, T value)                                              \
+{                                                                                                              \
+    (void)comp;                                                                                                \
+    *sum -= (long long)value;                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+long long circular_##K##_span(const T *src, size_t n)                                                          \
+{                                                                                                              \
+    long long acc = 0;                                                                                         \
+    for (size_t i = 0; i < n; ++i)                                                                             \
+    {                                                                                                          \
+        acc += (long long)src[i];                                                                              \
+    }                                                                                                          \
+    return acc;                                                                                                \
+}                                                                                                              \
+                                                                                                               \
+T circular_##K##_div(long long sum, size_t n)                                                                  \
+{                                                                                                              \
+    return (T)(sum / (long long)n);                                                                            \
+}                                                                                                              \
+                                                                                                               \
+T circular_##K##_divide(long long sum, const divisor_t *v)                                                     \
+{                                                                                                              \
+    return (T)divisor_divide(v, sum);                                                                          \
+}                                                                                                              \
+                                                                                                               \
+void circular_##K##_print(T value)                                                                             \
+{                                                                                                              \
+    printf(" " FMT, value);                                                                                    \
+}                                                                                                              \
+                                                                                                               \
+void circular_##K##_slide(long long *sum, long long *comp, const T *src, const divisor_t *v, T *avg_out, size_t n) \
+{                                                                                                              \
+    (void)comp;                                                                                                \
+    size_t w = v->d;                                                                                           \
+    long long acc = *sum;                                                                                      \
+    for (size_t i = 0; i < n; ++i)                                                                             \
+    {                                                                                                          \
+        acc += (long long)src[i] - (long long)src[i - w];                                                      \
+        avg_out[i] = (T)divisor_divide(v, acc);                                                                \
+    }                                                                                                          \
+    *sum = acc;                                                                                                \
+}
 
-    float acc = 0.0f;
-    for (size_t p = 0; p < b->size; ++p)
-    {
-        acc += (float)bufferd_get(b, p);
-    }
-    *avg = acc / ((float)b->size);
+// Default traits of a floating point type T (compensated double sums)
+#define CIRCULAR_DEFINE_FLOATING_TRAITS(K, T, FMT)                                                             \
+typedef double circular_##K##_sum_t;                                                                           \
+                                                                                                               \
+void circular_##K##_add(double *sum, double *comp, T value)                                                    \
+{                                                                                                              \
+    circular_compensated_add(sum, comp, (double)value);                                                        \
+}                                                                                                              \
+                                                                                                               \
+void circular_##K##_sub(double *sum, double *comp, T value)                                                    \
+{                                                                                                              \
+    circular_compensated_add(sum, comp, -(double)value);                                                       \
+}                                                                                                              \
+                                                                                                               \
+double circular_##K##_span(const T *src, size_t n)                                                             \
+{                                                                                                              \
+    double acc = 0.0;                                                                                          \
+    for (size_t i = 0; i < n; ++i)                                                                             \
+    {                                                                                                          \
+        acc += (double)src[i];                                                                                 \
+    }                                                                                                          \
+    return acc;                                                                                                \
+}                                                                                                              \
+                                                                                                               \
+T circular_##K##_div(double sum, size_t n)                                                                     \
+{                                                                                                              \
+    return (T)(sum / (double)n);                                                                               \
+}                                                                                                              \
+                                                                                                               \
+T circular_##K##_divide(double sum, const divisor_t *v)                                                        \
+{                                                                                                              \
+    return (T)divisor_scale(v, sum);                                                                           \
+}                                                                                                              \
+                                                                                                               \
+void circular_##K##_print(T value)                                                                             \
+{                                                                                                              \
+    printf(" " FMT, value);                                                                                    \
+}                                                                                                              \
+                                                                                                               \
+void circular_##K##_slide(double *sum, double *comp, const T *src, const divisor_t *v, T *avg_out, size_t n)   \
+{                                                                                                              \
+    size_t w = v->d;                                                                                           \
+    for (size_t i = 0; i < n; ++i)                                                                             \
+    {                                                                                                          \
+        circular_compensated_add(sum, comp, (double)src[i]);                                                   \
+        circular_compensated_add(sum, comp, -(double)src[i - w]);                                              \
+        avg_out[i] = (T)divisor_scale(v, *sum + *comp);                                                        \
+    }                                                                                                          \
 }
 
+CIRCULAR_DEFINE_INTEGER_TRAITS(short, short, "%hd")
+CIRCULAR_DEFINE_INTEGER_TRAITS(ushort, unsigned short, "%hu")
+CIRCULAR_DEFINE_INTEGER_TRAITS(uint, unsigned int, "%u")
 
 /******************************************************************************************
  *                                                                                        *
- *                                  FLOAT  VALUES                                         *
+ *                                  RING DEFINITION                                       *
  *                                                                                        *
  ******************************************************************************************/
 
-typedef struct bufferf_st
-{
-    float *data;       // buffer data pointer
-    size_t max_size; // maximum circular buffer size
-    size_t size;     // circular buffer size
-    size_t cur;      // cursor position
-} bufferf_t;
-
-// If you want a memory deallocation look for bufferf_free(bufferf_t *b).
-// This is just a quick clear, without writing zeros, the data is still available.
-void bufferf_clear(bufferf_t *b)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
-
-    // initializing size as 0
-    b->size = 0;
-
-    // initializing cursor as 0
-    b->cur = 0;
+// The circular buffers are generated from the single definition below, for any element type T
+// with circular_K_* traits, K being a single token naming the traits (see ELEMENT TRAITS).
+// The *_TRAITS(name, T, K, ...) macros take both, so T can be any type, e.g. unsigned int with K = uint.
+// The shorter forms below use T as K, for the single token types with traits (int, double, float, short...):
+//
+// CIRCULAR_DEFINE(name, T) generates name_t with heap storage and a runtime max_size,
+//     name_init/name_init_pow2/name_free (bufferi_t, bufferd_t and bufferf_t are these).
+// CIRCULAR_DEFINE_FIXED(name, T, N) generates name_t with inline storage of N values and no allocation,
+//     N is both the window and the capacity, so every wrap and the full window loops use a constant
+//     and get constant folded, unrolled and vectorized.
+// CIRCULAR_DEFINE_MIRROR(name, T) generates name_t with a power of two capacity mapped twice back to back
+//     (memfd_create), so any window is one contiguous range: name_data_ptr gives it without any copy.
+//     The capacity is rounded up to whole pages, without memfd_create the ring falls back to a heap allocation
+//     (mapped is 0, name_data_ptr then rotates a wrapped window). bufferi_mirror_t, bufferd_mirror_t, bufferf_mirror_t.
+// DEFINE_RING(T, N) is CIRCULAR_DEFINE_FIXED(ring_T_N, T, N), e.g. DEFINE_RING(int, 128) gives ring_int_128_t
+//     (N has to be an integer literal, or a macro expanding to one).
+//     DEFINE_RING_TRAITS(T, K, N) names it ring_K_N, e.g. DEFINE_RING_TRAITS(unsigned int, uint, 64) gives ring_uint_64_t.
+//
+// All share the operations of CIRCULAR_DEFINE_OPS: at, get, push_back, pop_front, segments (the window as
+// at most two contiguous regions), copy_out, copy_in, pop_many, print, push_and_pop,
+// scan (O(n) sum), average and scale (sum / size), avgi, avgd, avgf, sum, mean (O(1)) and push_many.
+// Full window averages use the divisor_t of the window (see divisor.h) instead of a division.
+// The storage macros provide wrap, capacity, linear (contiguous values from a position), window and has_data.
+// Comments inside the macros use /* */, a // comment would swallow the line continuation.
+
+#define CIRCULAR_DEFINE_OPS(name, T, K)                                                                        \
+T *name##_at(name##_t *b, size_t pos)                                                                          \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && name##_has_data(b));                                                          \
+                                                                                                               \
+    /* return pointer to circular position in buffer data */                                                   \
+    return &(b->data[name##_wrap(b, pos + b->cur)]);                                                           \
+}                                                                                                              \
+                                                                                                               \
+T name##_get(name##_t *b, size_t pos)                                                                          \
+{                                                                                                              \
+    /* check if position is valid */                                                                           \
+    CIRCULAR_ASSERT(pos < b->size);                                                                            \
+                                                                                                               \
+    /* return value from circular position in buffer data */                                                   \
+    return *name##_at(b, pos);                                                                                 \
+}                                                                                                              \
+                                                                                                               \
+void name##_push_back(name##_t *b, T value)                                                                    \
+{                                                                                                              \
+    /* check if buffer is not null and not full */                                                             \
+    CIRCULAR_ASSERT(b != NULL && b->size < name##_window(b));                                                  \
+                                                                                                               \
+    /* set data at the position after the last value */                                                        \
+    *name##_at(b, b->size) = value;                                                                            \
+                                                                                                               \
+    /* add value to the running sum */                                                                         \
+    CIRCULAR_RUNNING(circular_##K##_add(&b->sum, &b->comp, value));                                            \
+                                                                                                               \
+    /* increment the circular buffer size */                                                                   \
+    b->size++;                                                                                                 \
+}                                                                                                              \
+                                                                                                               \
+void name##_pop_front(name##_t *b, T *value)                                                                   \
+{                                                                                                              \
+    /* check if buffer is not null and not empty */                                                            \
+    CIRCULAR_ASSERT(b != NULL && b->size > 0);                                                                 \
+                                                                                                               \
+    /* get position of the first value */                                                                      \
+    T *data = name##_at(b, 0);                                                                                 \
+                                                                                                               \
+    /* sets value from first element in the circular buffer */                                                 \
+    if (value != NULL)                                                                                         \
+    {                                                                                                          \
+        *value = *data;                                                                                        \
+    }                                                                                                          \
+                                                                                                               \
+    /* remove first element from the running sum */                                                            \
+    CIRCULAR_RUNNING(circular_##K##_sub(&b->sum, &b->comp, *data));                                            \
+                                                                                                               \
+    /* decrement the circular buffer size */                                                                   \
+    b->size--;                                                                                                 \
+                                                                                                               \
+    /* move buffer cursor */                                                                                   \
+    b->cur = name##_wrap(b, b->cur + 1);                                                                       \
+}                                                                                                              \
+                                                                                                               \
+/* The window as at most two contiguous regions, oldest values first: [p1, p1 + n1) then [p2, p2 + n2). */     \
+/* Returns the number of non empty regions, an empty one is (NULL, 0). */                                      \
+size_t name##_segments(name##_t *b, const T **p1, size_t *n1, const T **p2, size_t *n2)                        \
+{                                                                                                              \
+    /* check if buffer and outputs are not null */                                                             \
+    CIRCULAR_ASSERT(b != NULL && p1 != NULL && n1 != NULL && p2 != NULL && n2 != NULL);                        \
+                                                                                                               \
+    *p1 = NULL;                                                                                                \
+    *n1 = 0;                                                                                                   \
+    *p2 = NULL;                                                                                                \
+    *n2 = 0;                                                                                                   \
+    if (b->size == 0)                                                                                          \
+    {                                                                                                          \
+        return 0;                                                                                              \
+    }                                                                                                          \
+                                                                                                               \
+    size_t first = name##_linear(b, b->cur);                                                                   \
+    if (first > b->size)                                                                                       \
+    {                                                                                                          \
+        first = b->size;                                                                                       \
+    }                                                                                                          \
+    *p1 = b->data + b->cur;                                                                                    \
+    *n1 = first;                                                                                               \
+    if (first == b->size)                                                                                      \
+    {                                                                                                          \
+        return 1;                                                                                              \
+    }                                                                                                          \
+    *p2 = b->data;                                                                                             \
+    *n2 = b->size - first;                                                                                     \
+    return 2;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* Copies the values at positions [pos, pos + n) of the window (0 is the oldest) to dst, */                    \
+/* clamped to the window. Returns the number of values copied. */                                              \
+size_t name##_copy_out(name##_t *b, size_t pos, T *dst, size_t n)                                              \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && name##_has_data(b));                                                          \
+                                                                                                               \
+    if (pos >= b->size)                                                                                        \
+    {                                                                                                          \
+        return 0;                                                                                              \
+    }                                                                                                          \
+    if (n > b->size - pos)                                                                                     \
+    {                                                                                                          \
+        n = b->size - pos;                                                                                     \
+    }                                                                                                          \
+                                                                                                               \
+    /* check if destination is not null */                                                                     \
+    CIRCULAR_ASSERT(dst != NULL || n == 0);                                                                    \
+                                                                                                               \
+    size_t start = name##_wrap(b, b->cur + pos);                                                               \
+    size_t first = name##_linear(b, start);                                                                    \
+    if (first > n)                                                                                             \
+    {                                                                                                          \
+        first = n;                                                                                             \
+    }                                                                                                          \
+    memcpy(dst, b->data + start, first * sizeof(T));                                                           \
+    memcpy(dst + first, b->data, (n - first) * sizeof(T));                                                     \
+    return n;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* Appends up to n values of src without evicting anything (push_many evicts), */                              \
+/* clamped to the free room of the window. Returns the number of values appended. */                           \
+size_t name##_copy_in(name##_t *b, const T *src, size_t n)                                                     \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && name##_has_data(b));                                                          \
+                                                                                                               \
+    size_t room = name##_window(b) - b->size;                                                                  \
+    if (n > room)                                                                                              \
+    {                                                                                                          \
+        n = room;                                                                                              \
+    }                                                                                                          \
+                                                                                                               \
+    /* check if source is not null */                                                                          \
+    CIRCULAR_ASSERT(src != NULL || n == 0);                                                                    \
+                                                                                                               \
+    size_t pos = name##_wrap(b, b->cur + b->size);                                                             \
+    size_t first = name##_linear(b, pos);                                                                      \
+    if (first > n)                                                                                             \
+    {                                                                                                          \
+        first = n;                                                                                             \
+    }                                                                                                          \
+    memcpy(b->data + pos, src, first * sizeof(T));                                                             \
+    memcpy(b->data, src + first, (n - first) * sizeof(T));                                                     \
+                                                                                                               \
+    /* add the new values to the running sum */                                                                \
+    for (size_t i = 0; i < n; ++i)                                                                             \
+    {                                                                                                          \
+        CIRCULAR_RUNNING(circular_##K##_add(&b->sum, &b->comp, src[i]));                                       \
+    }                                                                                                          \
+    b->size += n;                                                                                              \
+    return n;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* Evicts the n oldest values (clamped to the window), copying them to dst unless it is NULL. */               \
+/* Returns the number of values evicted. */                                                                    \
+size_t name##_pop_many(name##_t *b, T *dst, size_t n)                                                          \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && name##_has_data(b));                                                          \
+                                                                                                               \
+    if (n > b->size)                                                                                           \
+    {                                                                                                          \
+        n = b->size;                                                                                           \
+    }                                                                                                          \
+    if (dst != NULL)                                                                                           \
+    {                                                                                                          \
+        name##_copy_out(b, 0, dst, n);                                                                         \
+    }                                                                                                          \
+                                                                                                               \
+    /* remove the evicted values from the running sum, an empty window restarts from an exact 0 */             \
+    if (n == b->size)                                                                                          \
+    {                                                                                                          \
+        b->sum = 0;                                                                                            \
+        b->comp = 0;                                                                                           \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        size_t first = name##_linear(b, b->cur);                                                               \
+        if (first > n)                                                                                         \
+        {                                                                                                      \
+            first = n;                                                                                         \
+        }                                                                                                      \
+        for (size_t i = 0; i < first; ++i)                                                                     \
+        {                                                                                                      \
+            CIRCULAR_RUNNING(circular_##K##_sub(&b->sum, &b->comp, b->data[b->cur + i]));                      \
+        }                                                                                                      \
+        for (size_t i = 0; i < n - first; ++i)                                                                 \
+        {                                                                                                      \
+            CIRCULAR_RUNNING(circular_##K##_sub(&b->sum, &b->comp, b->data[i]));                               \
+        }                                                                                                      \
+    }                                                                                                          \
+                                                                                                               \
+    b->size -= n;                                                                                              \
+    b->cur = name##_wrap(b, b->cur + n);                                                                       \
+    return n;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+void name##_print(name##_t *b)                                                                                 \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    printf(#name ":");                                                                                         \
+    if (b->size > 0)                                                                                           \
+    {                                                                                                          \
+        const T *p[2];                                                                                         \
+        size_t n[2];                                                                                           \
+        name##_segments(b, &p[0], &n[0], &p[1], &n[1]);                                                        \
+        for (size_t s = 0; s < 2; ++s)                                                                         \
+        {                                                                                                      \
+            for (size_t i = 0; i < n[s]; ++i)                                                                  \
+            {                                                                                                  \
+                circular_##K##_print(p[s][i]);                                                                 \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+    printf("\n");                                                                                              \
+}                                                                                                              \
+                                                                                                               \
+void name##_push_and_pop(name##_t *b, T push_value, T *pop_value)                                              \
+{                                                                                                              \
+    /* pop front before overflowing */                                                                         \
+    name##_pop_front(b, pop_value);                                                                            \
+                                                                                                               \
+    /* push back after removing first element */                                                               \
+    name##_push_back(b, push_value);                                                                           \
+}                                                                                                              \
+                                                                                                               \
+/* Sum of the window in O(n), the window is split in two contiguous spans: [cur, capacity) and [0, wrap) */    \
+/* (a single span for the mirrored storage). */                                                                \
+/* A full window is the whole data, a single loop of capacity iterations (a constant for fixed buffers). */    \
+circular_##K##_sum_t name##_scan(name##_t *b)                                                                  \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && name##_has_data(b));                                                          \
+                                                                                                               \
+    size_t capacity = name##_capacity(b);                                                                      \
+    if (b->size == capacity)                                                                                   \
+    {                                                                                                          \
+        return circular_##K##_span(b->data, capacity);                                                         \
+    }                                                                                                          \
+                                                                                                               \
+    size_t first = name##_linear(b, b->cur);                                                                   \
+    if (first > b->size)                                                                                       \
+    {                                                                                                          \
+        first = b->size;                                                                                       \
+    }                                                                                                          \
+    return circular_##K##_span(b->data + b->cur, first) + circular_##K##_span(b->data, b->size - first);       \
+}                                                                                                              \
+                                                                                                               \
+/* sum / size, truncated for integers. Once the window is full the divisor never changes, */                   \
+/* the precomputed window divisor replaces the division (exactly, for integers) */                             \
+T name##_average(name##_t *b, circular_##K##_sum_t sum)                                                        \
+{                                                                                                              \
+    if (b->size == name##_window(b))                                                                           \
+    {                                                                                                          \
+        return circular_##K##_divide(sum, &b->divisor);                                                        \
+    }                                                                                                          \
+    return circular_##K##_div(sum, b->size);                                                                   \
+}                                                                                                              \
+                                                                                                               \
+/* x / size in floating point, a multiplication by the reciprocal once the window is full */                   \
+double name##_scale(name##_t *b, double x)                                                                     \
+{                                                                                                              \
+    if (b->size == name##_window(b))                                                                           \
+    {                                                                                                          \
+        return divisor_scale(&b->divisor, x);                                                                  \
+    }                                                                                                          \
+    return x / (double)b->size;                                                                                \
+}                                                                                                              \
+                                                                                                               \
+/* Average of the window in O(n), truncated for integers */                                                    \
+void name##_avgi(name##_t *b, int *avg)                                                                        \
+{                                                                                                              \
+    /* check if buffer is not null and avg return is not null */                                               \
+    CIRCULAR_ASSERT(b != NULL && avg != NULL);                                                                 \
+                                                                                                               \
+    *avg = (int)name##_average(b, name##_scan(b));                                                             \
+}                                                                                                              \
+                                                                                                               \
+void name##_avgd(name##_t *b, double *avg)                                                                     \
+{                                                                                                              \
+    /* check if buffer is not null and avg return is not null */                                               \
+    CIRCULAR_ASSERT(b != NULL && avg != NULL);                                                                 \
+                                                                                                               \
+    *avg = name##_scale(b, (double)name##_scan(b));                                                            \
+}                                                                                                              \
+                                                                                                               \
+void name##_avgf(name##_t *b, float *avg)                                                                      \
+{                                                                                                              \
+    /* check if buffer is not null and avg return is not null */                                               \
+    CIRCULAR_ASSERT(b != NULL && avg != NULL);                                                                 \
+                                                                                                               \
+    *avg = (float)name##_scale(b, (double)name##_scan(b));                                                     \
+}                                                                                                              \
+                                                                                                               \
+/* Sum of the window in O(1), read from the (compensated) running sum */                                       \
+circular_##K##_sum_t name##_sum(name##_t *b)                                                                   \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    return CIRCULAR_SUM(b->sum + b->comp, name##_scan(b));                                                     \
+}                                                                                                              \
+                                                                                                               \
+/* Average of the window in O(1), same rounding as avgi for integers */                                        \
+T name##_mean(name##_t *b)                                                                                     \
+{                                                                                                              \
+    /* check if circular buffer is not empty */                                                                \
+    CIRCULAR_ASSERT(b != NULL && b->size > 0);                                                                 \
+                                                                                                               \
+    return name##_average(b, name##_sum(b));                                                                   \
+}                                                                                                              \
+                                                                                                               \
+/* Pushes n values from src, evicting the oldest ones once the buffer is full, */                              \
+/* and writes in avg_out[i] the window average right after src[i] was pushed */                                \
+/* (same result as push_back/push_and_pop followed by name##_mean for each value). */                          \
+/* The ring is only read for the evicted values and written once at the end, */                                \
+/* once the window is full the evicted values are read straight from src. */                                   \
+/* avg_out can be NULL when only the final buffer state is needed. */                                          \
+void name##_push_many(name##_t *b, const T *src, size_t n, T *avg_out)                                         \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && name##_has_data(b) && name##_window(b) > 0);                                  \
+                                                                                                               \
+    /* check if source is not null */                                                                          \
+    CIRCULAR_ASSERT(src != NULL || n == 0);                                                                    \
+                                                                                                               \
+    size_t w = name##_window(b);                                                                               \
+    size_t s0 = b->size;                                                                                       \
+    circular_##K##_sum_t sum = name##_sum(b);                                                                  \
+    circular_##K##_sum_t comp = 0;                                                                             \
+    size_t i = 0;                                                                                              \
+                                                                                                               \
+    /* warm-up: the window is still growing, nothing is evicted */                                             \
+    for (; i < n && s0 + i < w; ++i)                                                                           \
+    {                                                                                                          \
+        circular_##K##_add(&sum, &comp, src[i]);                                                               \
+        if (avg_out != NULL)                                                                                   \
+        {                                                                                                      \
+            avg_out[i] = circular_##K##_div(sum + comp, s0 + i + 1);                                           \
+        }                                                                                                      \
+    }                                                                                                          \
+                                                                                                               \
+    /* the evicted values are still in the ring */                                                             \
+    for (; i < n && i < w; ++i)                                                                                \
+    {                                                                                                          \
+        circular_##K##_add(&sum, &comp, src[i]);                                                               \
+        circular_##K##_sub(&sum, &comp, b->data[name##_wrap(b, b->cur + s0 + i - w)]);                         \
+        if (avg_out != NULL)                                                                                   \
+        {                                                                                                      \
+            avg_out[i] = circular_##K##_divide(sum + comp, &b->divisor);                                       \
+        }                                                                                                      \
+    }                                                                                                          \
+                                                                                                               \
+    /* steady state: the evicted values are read from src */                                                   \
+    if (i < n && avg_out == NULL)                                                                              \
+    {                                                                                                          \
+        /* only the last window matters */                                                                     \
+        sum = circular_##K##_span(src + n - w, w);                                                             \
+        comp = 0;                                                                                              \
+        i = n;                                                                                                 \
+    }                                                                                                          \
+    if (i < n)                                                                                                 \
+    {                                                                                                          \
+        circular_##K##_slide(&sum, &comp, src + i, &b->divisor, avg_out + i, n - i);                           \
+    }                                                                                                          \
+                                                                                                               \
+    /* leave the ring holding the last window of (ring + src) */                                               \
+    if (n >= w)                                                                                                \
+    {                                                                                                          \
+        memcpy(b->data, src + n - w, w * sizeof(T));                                                           \
+        b->cur = 0;                                                                                            \
+        b->size = w;                                                                                           \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        size_t evicted = (s0 + n > w) ? s0 + n - w : 0;                                                        \
+        b->cur = name##_wrap(b, b->cur + evicted);                                                             \
+        b->size = s0 - evicted;                                                                                \
+                                                                                                               \
+        /* append src after the kept values, in at most two contiguous spans */                                \
+        size_t pos = name##_wrap(b, b->cur + b->size);                                                         \
+        size_t first = name##_linear(b, pos);                                                                  \
+        if (first > n)                                                                                         \
+        {                                                                                                      \
+            first = n;                                                                                         \
+        }                                                                                                      \
+        memcpy(b->data + pos, src, first * sizeof(T));                                                         \
+        memcpy(b->data, src + first, (n - first) * sizeof(T));                                                 \
+        b->size += n;                                                                                          \
+    }                                                                                                          \
+                                                                                                               \
+    /* the running sum of the new window */                                                                    \
+    CIRCULAR_RUNNING(b->sum = sum);                                                                            \
+    CIRCULAR_RUNNING(b->comp = comp);                                                                          \
 }
 
-void bufferf_init(bufferf_t *b, size_t max_size)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
-
-    // allocate the requested size
-    b->data = (float *)malloc(max_size * sizeof(float));
-
-    // check if data allocation was successful
-    if (b->data != NULL)
-    {
-        // setting up a valid max_size after checking allocation
-        b->max_size = max_size;
-    }
-    else
-    {
-        // setting up a valid max_size after failing allocation
-        b->max_size = 0;
-    }
 
-    // initializing size and cur as 0
-    bufferf_clear(b);
+#define CIRCULAR_DEFINE_TRAITS(name, T, K)                                                                     \
+typedef struct name##_st                                                                                       \
+{                                                                                                              \
+    T *data;                     /* buffer data pointer */                                                     \
+    size_t max_size;             /* maximum circular buffer size */                                            \
+    size_t size;                 /* circular buffer size */                                                    \
+    size_t cur;                  /* cursor position */                                                         \
+    size_t capacity;             /* allocated data size (>= max_size) */                                       \
+    size_t mask;                 /* capacity - 1 when capacity is a power of two, 0 otherwise */               \
+    circular_##K##_sum_t sum;    /* running sum of the window */                                               \
+    circular_##K##_sum_t comp;   /* running sum compensation (lost low order bits), 0 for exact sums */        \
+    divisor_t divisor;           /* max_size divisor, replaces the division of the full window averages */     \
+} name##_t;                                                                                                    \
+                                                                                                               \
+/* If you want a memory deallocation look for name##_free. */                                                  \
+/* This is just a quick clear, without writing zeros, the data is still available. */                          \
+void name##_clear(name##_t *b)                                                                                 \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    /* initializing size, cursor and running sum as 0 */                                                       \
+    b->size = 0;                                                                                               \
+    b->cur = 0;                                                                                                \
+    b->sum = 0;                                                                                                \
+    b->comp = 0;                                                                                               \
+}                                                                                                              \
+                                                                                                               \
+void name##_init(name##_t *b, size_t max_size)                                                                 \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    /* allocate the requested size */                                                                          \
+    b->data = (T *)malloc(max_size * sizeof(T));                                                               \
+                                                                                                               \
+    /* setting up a valid max_size after checking allocation */                                                \
+    b->max_size = (b->data != NULL) ? max_size : 0;                                                            \
+                                                                                                               \
+    /* the whole allocation is used, positions are wrapped with a modulo */                                    \
+    /* unless max_size already is a power of two */                                                            \
+    b->capacity = b->max_size;                                                                                 \
+    b->mask = (b->capacity != 0 && (b->capacity & (b->capacity - 1)) == 0) ? b->capacity - 1 : 0;              \
+    divisor_init(&b->divisor, b->max_size);                                                                    \
+                                                                                                               \
+    /* initializing size and cur as 0 */                                                                       \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+/* Same as init, but the data is allocated with a power of two capacity, */                                    \
+/* so the positions are wrapped with an AND instead of a modulo. */                                            \
+/* max_size is still the logical window size, only the allocation grows. */                                    \
+void name##_init_pow2(name##_t *b, size_t max_size)                                                            \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    size_t capacity = circular_next_pow2(max_size);                                                            \
+                                                                                                               \
+    /* allocate the rounded up size */                                                                         \
+    b->data = (T *)malloc(capacity * sizeof(T));                                                               \
+                                                                                                               \
+    /* setting up a valid max_size and mask after checking allocation */                                       \
+    b->max_size = (b->data != NULL) ? max_size : 0;                                                            \
+    b->capacity = (b->data != NULL) ? capacity : 0;                                                            \
+    b->mask = (b->data != NULL) ? capacity - 1 : 0;                                                            \
+    divisor_init(&b->divisor, b->max_size);                                                                    \
+                                                                                                               \
+    /* initializing size and cur as 0 */                                                                       \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+void name##_free(name##_t *b)                                                                                  \
+{                                                                                                              \
+    /* check if buffer is not null and data is allocated before trying to deallocate */                        \
+    CIRCULAR_ASSERT(b != NULL && b->data != NULL);                                                             \
+                                                                                                               \
+    /* free data, just making sure the previous pointer is invalid */                                          \
+    free(b->data);                                                                                             \
+    b->data = NULL;                                                                                            \
+                                                                                                               \
+    /* making sure the max_size, size and cur verifications will be coherent */                                \
+    b->max_size = 0;                                                                                           \
+    b->capacity = 0;                                                                                           \
+    b->mask = 0;                                                                                               \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+/* Wraps a raw position into the allocated data, a single AND for a power of two capacity */                   \
+size_t name##_wrap(name##_t *b, size_t pos)                                                                    \
+{                                                                                                              \
+    if (b->mask != 0)                                                                                          \
+    {                                                                                                          \
+        return pos & b->mask;                                                                                  \
+    }                                                                                                          \
+    return pos % b->capacity;                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_capacity(name##_t *b)                                                                            \
+{                                                                                                              \
+    return b->capacity;                                                                                        \
+}                                                                                                              \
+                                                                                                               \
+/* Values readable or writable contiguously from data + pos (pos < capacity) */                                \
+size_t name##_linear(name##_t *b, size_t pos)                                                                  \
+{                                                                                                              \
+    return b->capacity - pos;                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_window(name##_t *b)                                                                              \
+{                                                                                                              \
+    return b->max_size;                                                                                        \
+}                                                                                                              \
+                                                                                                               \
+int name##_has_data(name##_t *b)                                                                               \
+{                                                                                                              \
+    return b->data != NULL;                                                                                    \
+}                                                                                                              \
+                                                                                                               \
+CIRCULAR_DEFINE_OPS(name, T, K)
+
+#define CIRCULAR_DEFINE_MIRROR_TRAITS(name, T, K)                                                              \
+typedef struct name##_st                                                                                       \
+{                                                                                                              \
+    T *data;                     /* first view of the data, the second one follows it */                       \
+    size_t max_size;             /* maximum circular buffer size */                                            \
+    size_t size;                 /* circular buffer size */                                                    \
+    size_t cur;                  /* cursor position */                                                         \
+    size_t capacity;             /* values in one view, a power of two */                                      \
+    size_t mask;                 /* capacity - 1 */                                                            \
+    size_t mapped;               /* bytes of one view, 0 when the data is a plain heap allocation */           \
+    circular_##K##_sum_t sum;    /* running sum of the window */                                               \
+    circular_##K##_sum_t comp;   /* running sum compensation (lost low order bits), 0 for exact sums */        \
+    divisor_t divisor;           /* max_size divisor, replaces the division of the full window averages */     \
+} name##_t;                                                                                                    \
+                                                                                                               \
+void name##_clear(name##_t *b)                                                                                 \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    /* initializing size, cursor and running sum as 0 */                                                       \
+    b->size = 0;                                                                                               \
+    b->cur = 0;                                                                                                \
+    b->sum = 0;                                                                                                \
+    b->comp = 0;                                                                                               \
+}                                                                                                              \
+                                                                                                               \
+/* The capacity is rounded up to a power of two filling whole pages, so small windows are mirrored too. */     \
+/* Systems without memfd_create fall back to a heap allocation with wrapped accesses (mapped is 0). */         \
+void name##_init(name##_t *b, size_t max_size)                                                                 \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    size_t capacity = circular_next_pow2(max_size);                                                            \
+    size_t mirrored = circular_mirror_capacity(capacity, sizeof(T));                                           \
+                                                                                                               \
+    /* two views of the same pages; a window below a page is mapped as a whole page rather than */             \
+    /* falling back to the heap, so data_ptr stays O(1) for every window (at the cost of a page) */            \
+    b->mapped = mirrored * sizeof(T);                                                                          \
+    b->data = (b->mapped != 0) ? (T *)circular_mirror_map(b->mapped) : NULL;                                   \
+    if (b->data != NULL)                                                                                       \
+    {                                                                                                          \
+        capacity = mirrored;                                                                                   \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        b->mapped = 0;                                                                                         \
+        b->data = (T *)malloc(capacity * sizeof(T));                                                           \
+    }                                                                                                          \
+                                                                                                               \
+    /* setting up a valid max_size and mask after checking allocation */                                       \
+    b->max_size = (b->data != NULL) ? max_size : 0;                                                            \
+    b->capacity = (b->data != NULL) ? capacity : 0;                                                            \
+    b->mask = (b->data != NULL) ? capacity - 1 : 0;                                                            \
+    divisor_init(&b->divisor, b->max_size);                                                                    \
+                                                                                                               \
+    /* initializing size and cur as 0 */                                                                       \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+void name##_free(name##_t *b)                                                                                  \
+{                                                                                                              \
+    /* check if buffer is not null and data is allocated before trying to deallocate */                        \
+    CIRCULAR_ASSERT(b != NULL && b->data != NULL);                                                             \
+                                                                                                               \
+    if (b->mapped != 0)                                                                                        \
+    {                                                                                                          \
+        circular_mirror_unmap(b->data, b->mapped);                                                             \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        free(b->data);                                                                                         \
+    }                                                                                                          \
+    b->data = NULL;                                                                                            \
+                                                                                                               \
+    /* making sure the max_size, size and cur verifications will be coherent */                                \
+    b->max_size = 0;                                                                                           \
+    b->capacity = 0;                                                                                           \
+    b->mask = 0;                                                                                               \
+    b->mapped = 0;                                                                                             \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_wrap(name##_t *b, size_t pos)                                                                    \
+{                                                                                                              \
+    if (b->mask != 0)                                                                                          \
+    {                                                                                                          \
+        return pos & b->mask;                                                                                  \
+    }                                                                                                          \
+    return pos % b->capacity;                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_capacity(name##_t *b)                                                                            \
+{                                                                                                              \
+    return b->capacity;                                                                                        \
+}                                                                                                              \
+                                                                                                               \
+/* The second view continues the first one, a whole capacity is contiguous from any position */                \
+size_t name##_linear(name##_t *b, size_t pos)                                                                  \
+{                                                                                                              \
+    return (b->mapped != 0) ? b->capacity : b->capacity - pos;                                                 \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_window(name##_t *b)                                                                              \
+{                                                                                                              \
+    return b->max_size;                                                                                        \
+}                                                                                                              \
+                                                                                                               \
+int name##_has_data(name##_t *b)                                                                               \
+{                                                                                                              \
+    return b->data != NULL;                                                                                    \
+}                                                                                                              \
+                                                                                                               \
+/* The window as one contiguous range of size values, oldest first. */                                         \
+/* O(1) with the mirrored views, the heap fallback rotates a wrapped window to the front first. */             \
+T *name##_data_ptr(name##_t *b)                                                                                \
+{                                                                                                              \
+    /* check if buffer is not null and has data */                                                             \
+    CIRCULAR_ASSERT(b != NULL && b->data != NULL);                                                             \
+                                                                                                               \
+    if (b->mapped == 0 && b->cur + b->size > b->capacity)                                                      \
+    {                                                                                                          \
+        /* rotate left by cur with three reversals, the window starts at 0 */                                  \
+        circular_reverse(b->data, 0, b->cur, sizeof(T));                                                       \
+        circular_reverse(b->data, b->cur, b->capacity, sizeof(T));                                             \
+        circular_reverse(b->data, 0, b->capacity, sizeof(T));                                                  \
+        b->cur = 0;                                                                                            \
+    }                                                                                                          \
+    return b->data + b->cur;                                                                                   \
+}                                                                                                              \
+                                                                                                               \
+CIRCULAR_DEFINE_OPS(name, T, K)
+
+#define CIRCULAR_DEFINE_FIXED_TRAITS(name, T, K, N)                                                            \
+typedef struct name##_st                                                                                       \
+{                                                                                                              \
+    T data[N];                   /* inline buffer data, N is the window and the capacity */                    \
+    size_t size;                 /* circular buffer size */                                                    \
+    size_t cur;                  /* cursor position */                                                         \
+    circular_##K##_sum_t sum;    /* running sum of the window */                                               \
+    circular_##K##_sum_t comp;   /* running sum compensation (lost low order bits), 0 for exact sums */        \
+    divisor_t divisor;           /* N divisor, for the push_many steady state */                               \
+} name##_t;                                                                                                    \
+                                                                                                               \
+/* Nothing is allocated, clear and free only reset the window */                                               \
+void name##_clear(name##_t *b)                                                                                 \
+{                                                                                                              \
+    /* check if buffer is not null */                                                                          \
+    CIRCULAR_ASSERT(b != NULL);                                                                                \
+                                                                                                               \
+    /* initializing size, cursor and running sum as 0 */                                                       \
+    b->size = 0;                                                                                               \
+    b->cur = 0;                                                                                                \
+    b->sum = 0;                                                                                                \
+    b->comp = 0;                                                                                               \
+}                                                                                                              \
+                                                                                                               \
+void name##_init(name##_t *b)                                                                                  \
+{                                                                                                              \
+    divisor_init(&b->divisor, (N));                                                                            \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+void name##_free(name##_t *b)                                                                                  \
+{                                                                                                              \
+    name##_clear(b);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+/* Modulo by a constant, an AND when N is a power of two */                                                    \
+size_t name##_wrap(name##_t *b, size_t pos)                                                                    \
+{                                                                                                              \
+    (void)b;                                                                                                   \
+    return pos % (size_t)(N);                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_capacity(name##_t *b)                                                                            \
+{                                                                                                              \
+    (void)b;                                                                                                   \
+    return (N);                                                                                                \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_linear(name##_t *b, size_t pos)                                                                  \
+{                                                                                                              \
+    (void)b;                                                                                                   \
+    return (N) - pos;                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+size_t name##_window(name##_t *b)                                                                              \
+{                                                                                                              \
+    (void)b;                                                                                                   \
+    return (N);                                                                                                \
+}                                                                                                              \
+                                                                                                               \
+int name##_has_data(name##_t *b)                                                                               \
+{                                                                                                              \
+    (void)b;                                                                                                   \
+    return 1;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+CIRCULAR_DEFINE_OPS(name, T, K)
+
+
+// The element type is also the traits name when it is a single token with circular_T_* traits
+#define CIRCULAR_DEFINE(name, T) CIRCULAR_DEFINE_TRAITS(name, T, T)
+#define CIRCULAR_DEFINE_MIRROR(name, T) CIRCULAR_DEFINE_MIRROR_TRAITS(name, T, T)
+#define CIRCULAR_DEFINE_FIXED(name, T, N) CIRCULAR_DEFINE_FIXED_TRAITS(name, T, T, N)
+
+// Generates the ring with inline storage for N values named ring_T_N_t (ring_K_N_t with the traits K)
+#define DEFINE_RING(T, N) CIRCULAR_DEFINE_RING(T, N)
+#define CIRCULAR_DEFINE_RING(T, N) CIRCULAR_DEFINE_FIXED(ring_##T##_##N, T, N)
+#define DEFINE_RING_TRAITS(T, K, N) CIRCULAR_DEFINE_FIXED_TRAITS(ring_##K##_##N, T, K, N)
+
+
+// Sliding window minimum and maximum with monotonic deques (amortized O(1) per sample),
+// named name_t on top of the heap ring buffer_t (CIRCULAR_DEFINE(buffer, T)) holding the window samples,
+// so the average comes for free: name_init/name_clear/name_free/name_push/name_min/name_max.
+#define CIRCULAR_DEFINE_MINMAX(name, buffer, T)                                                                \
+typedef struct name##_st                                                                                       \
+{                                                                                                              \
+    buffer##_t window; /* window samples */                                                                    \
+    T *min_val;        /* increasing deque of window minimum candidates */                                     \
+    size_t *min_seq;   /* sample number of each min_val */                                                     \
+    size_t min_head;   /* min deque first position */                                                          \
+    size_t min_size;   /* min deque size */                                                                    \
+    T *max_val;        /* decreasing deque of window maximum candidates */                                     \
+    size_t *max_seq;   /* sample number of each max_val */                                                     \
+    size_t max_head;   /* max deque first position */                                                          \
+    size_t max_size;   /* max deque size */                                                                    \
+    size_t mask;       /* deque capacity - 1 (power of two) */                                                 \
+    size_t seq;        /* number of samples pushed so far */                                                   \
+} name##_t;                                                                                                    \
+                                                                                                               \
+/* Quick clear, the allocations are kept */                                                                    \
+void name##_clear(name##_t *m)                                                                                 \
+{                                                                                                              \
+    /* check if min/max is not null */                                                                         \
+    CIRCULAR_ASSERT(m != NULL);                                                                                \
+                                                                                                               \
+    buffer##_clear(&m->window);                                                                                \
+    m->min_head = 0;                                                                                           \
+    m->min_size = 0;                                                                                           \
+    m->max_head = 0;                                                                                           \
+    m->max_size = 0;                                                                                           \
+    m->seq = 0;                                                                                                \
+}                                                                                                              \
+                                                                                                               \
+/* Returns 0 when an allocation fails, nothing is left allocated then */                                       \
+int name##_init(name##_t *m, size_t max_size)                                                                  \
+{                                                                                                              \
+    /* check if min/max is not null */                                                                         \
+    CIRCULAR_ASSERT(m != NULL);                                                                                \
+                                                                                                               \
+    /* a deque never holds more than max_size candidates */                                                    \
+    size_t capacity = circular_next_pow2(max_size);                                                            \
+                                                                                                               \
+    buffer##_init_pow2(&m->window, max_size);                                                                  \
+    m->min_val = (T *)malloc(capacity * sizeof(T));                                                            \
+    m->min_seq = (size_t *)malloc(capacity * sizeof(size_t));                                                  \
+    m->max_val = (T *)malloc(capacity * sizeof(T));                                                            \
+    m->max_seq = (size_t *)malloc(capacity * sizeof(size_t));                                                  \
+    m->mask = capacity - 1;                                                                                    \
+    if (!buffer##_has_data(&m->window) || m->min_val == NULL || m->min_seq == NULL || m->max_val == NULL ||    \
+        m->max_seq == NULL)                                                                                    \
+    {                                                                                                          \
+        if (buffer##_has_data(&m->window))                                                                     \
+        {                                                                                                      \
+            buffer##_free(&m->window);                                                                         \
+        }                                                                                                      \
+        free(m->min_val);                                                                                      \
+        free(m->min_seq);                                                                                      \
+        free(m->max_val);                                                                                      \
+        free(m->max_seq);                                                                                      \
+        m->min_val = NULL;                                                                                     \
+        m->min_seq = NULL;                                                                                     \
+        m->max_val = NULL;                                                                                     \
+        m->max_seq = NULL;                                                                                     \
+        m->mask = 0;                                                                                           \
+        return 0;                                                                                              \
+    }                                                                                                          \
+                                                                                                               \
+    /* initializing deques and window as empty */                                                              \
+    name##_clear(m);                                                                                           \
+    return 1;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+void name##_free(name##_t *m)                                                                                  \
+{                                                                                                              \
+    /* check if min/max is not null */                                                                         \
+    CIRCULAR_ASSERT(m != NULL);                                                                                \
+                                                                                                               \
+    buffer##_free(&m->window);                                                                                 \
+    free(m->min_val);                                                                                          \
+    free(m->min_seq);                                                                                          \
+    free(m->max_val);                                                                                          \
+    free(m->max_seq);                                                                                          \
+                                                                                                               \
+    /* just making sure the previous pointers are invalid */                                                   \
+    m->min_val = NULL;                                                                                         \
+    m->min_seq = NULL;                                                                                         \
+    m->max_val = NULL;                                                                                         \
+    m->max_seq = NULL;                                                                                         \
+    m->mask = 0;                                                                                               \
+    m->min_head = 0;                                                                                           \
+    m->min_size = 0;                                                                                           \
+    m->max_head = 0;                                                                                           \
+    m->max_size = 0;                                                                                           \
+    m->seq = 0;                                                                                                \
+}                                                                                                              \
+                                                                                                               \
+/* Pushes value into the window (evicting the oldest sample when full) */                                      \
+/* and reports the window minimum, maximum and average (any of them can be NULL). */                           \
+void name##_push(name##_t *m, T value, T *min, T *max, T *avg)                                                 \
+{                                                                                                              \
+    /* check if min/max is not null and deques are allocated */                                                \
+    CIRCULAR_ASSERT(m != NULL && m->min_val != NULL && m->max_val != NULL);                                    \
+                                                                                                               \
+    size_t w = m->window.max_size;                                                                             \
+                                                                                                               \
+    /* window samples */                                                                                       \
+    if (m->window.size < w)                                                                                    \
+    {                                                                                                          \
+        buffer##_push_back(&m->window, value);                                                                 \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        buffer##_push_and_pop(&m->window, value, NULL);                                                        \
+    }                                                                                                          \
+                                                                                                               \
+    /* drop the candidates that left the window */                                                             \
+    if (m->min_size > 0 && m->min_seq[m->min_head] + w <= m->seq)                                              \
+    {                                                                                                          \
+        m->min_head = (m->min_head + 1) & m->mask;                                                             \
+        m->min_size--;                                                                                         \
+    }                                                                                                          \
+    if (m->max_size > 0 && m->max_seq[m->max_head] + w <= m->seq)                                              \
+    {                                                                                                          \
+        m->max_head = (m->max_head + 1) & m->mask;                                                             \
+        m->max_size--;                                                                                         \
+    }                                                                                                          \
+                                                                                                               \
+    /* drop the candidates that can no longer be the minimum/maximum */                                        \
+    while (m->min_size > 0 && m->min_val[(m->min_head + m->min_size - 1) & m->mask] >= value)                  \
+    {                                                                                                          \
+        m->min_size--;                                                                                         \
+    }                                                                                                          \
+    while (m->max_size > 0 && m->max_val[(m->max_head + m->max_size - 1) & m->mask] <= value)                  \
+    {                                                                                                          \
+        m->max_size--;                                                                                         \
+    }                                                                                                          \
+                                                                                                               \
+    /* value is always a candidate for both */                                                                 \
+    size_t pos = (m->min_head + m->min_size) & m->mask;                                                        \
+    m->min_val[pos] = value;                                                                                   \
+    m->min_seq[pos] = m->seq;                                                                                  \
+    m->min_size++;                                                                                             \
+                                                                                                               \
+    pos = (m->max_head + m->max_size) & m->mask;                                                               \
+    m->max_val[pos] = value;                                                                                   \
+    m->max_seq[pos] = m->seq;                                                                                  \
+    m->max_size++;                                                                                             \
+                                                                                                               \
+    m->seq++;                                                                                                  \
+                                                                                                               \
+    /* the deque fronts are the window extremes */                                                             \
+    if (min != NULL)                                                                                           \
+    {                                                                                                          \
+        *min = m->min_val[m->min_head];                                                                        \
+    }                                                                                                          \
+    if (max != NULL)                                                                                           \
+    {                                                                                                          \
+        *max = m->max_val[m->max_head];                                                                        \
+    }                                                                                                          \
+    if (avg != NULL)                                                                                           \
+    {                                                                                                          \
+        *avg = buffer##_mean(&m->window);                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+T name##_min(name##_t *m)                                                                                      \
+{                                                                                                              \
+    /* check if min/max is not null and window is not empty */                                                 \
+    CIRCULAR_ASSERT(m != NULL && m->min_size > 0);                                                             \
+                                                                                                               \
+    return m->min_val[m->min_head];                                                                            \
+}                                                                                                              \
+                                                                                                               \
+T name##_max(name##_t *m)                                                                                      \
+{                                                                                                              \
+    /* check if min/max is not null and window is not empty */                                                 \
+    CIRCULAR_ASSERT(m != NULL && m->max_size > 0);                                                             \
+                                                                                                               \
+    return m->max_val[m->max_head];                                                                            \
 }
 
-void bufferf_free(bufferf_t *b)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
 
-    // check if data is allocated before trying to deallocate
-    assert(b->data != NULL);
-#endif
+/******************************************************************************************
+ *                                                                                        *
+ *                                  INT32 VALUES                                          *
+ *                                                                                        *
+ ******************************************************************************************/
+CIRCULAR_DEFINE(bufferi, int)
+CIRCULAR_DEFINE_MIRROR(bufferi_mirror, int)
 
-    // free data
-    free(b->data);
+CIRCULAR_DEFINE_MINMAX(bufferi_minmax, bufferi, int)
 
-    // just making sure the previous pointer is invalid
-    b->data = NULL;
 
-    // making sure the max_size verifications will be coherent
-    b->max_size = 0;
+/******************************************************************************************
+ *                                                                                        *
+ *                                  DOUBLE VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
 
-    // making sure the size and cur verifications will be coherent
-    bufferf_clear(b);
-}
+CIRCULAR_DEFINE(bufferd, double)
+CIRCULAR_DEFINE_MIRROR(bufferd_mirror, double)
 
-float *bufferf_at(bufferf_t *b, size_t pos)
+CIRCULAR_DEFINE_MINMAX(bufferd_minmax, bufferd, double)
+
+// Sliding window mean and variance with Welford updates (O(1) per sample).
+// A push adds the value to mean/m2 and an eviction replaces the oldest value,
+// so there is no second pass over the window.
+// Every CIRCULAR_VARIANCE_RESYNC samples mean/m2 are recomputed from the window
+// to keep long runs (hundreds of millions of samples) from drifting.
+typedef struct bufferd_stats_st
+{
+    bufferd_t window; // window samples
+    double mean;      // window mean (Welford)
+    double m2;        // sum of squared deviations from the mean
+    size_t count;     // samples since last recomputation
+} bufferd_stats_t;
+
+// Quick clear, the allocation is kept
+void bufferd_stats_clear(bufferd_stats_t *s)
 {
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if buffer has data
-    assert(b->data != NULL);
+    // check if stats is not null
+    assert(s != NULL);
 #endif
 
-    size_t circular_pos = (pos + b->cur) % b->max_size;
-
-    // check if position is valid in buffer data
-    // assert(circular_pos > -1 && circular_pos < b->max_size);
-
-    // return pointer to circular position in buffer data
-    return &(b->data[circular_pos]);
+    bufferd_clear(&s->window);
+    s->mean = 0.0;
+    s->m2 = 0.0;
+    s->count = 0;
 }
 
-float bufferf_get(bufferf_t *b, size_t pos)
+void bufferd_stats_init(bufferd_stats_t *s, size_t max_size)
 {
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if buffer has data
-    assert(b->data != NULL);
-
-    // check if position is valid
-    assert((pos >= 0) && (pos < b->size));
+    // check if stats is not null
+    assert(s != NULL);
 #endif
 
-    // return value from circular position in buffer data
-    return *bufferf_at(b, pos);
+    bufferd_init_pow2(&s->window, max_size);
+
+    // initializing window and moments as empty
+    bufferd_stats_clear(s);
 }
 
-void bufferf_push_back(bufferf_t *b, float value)
+void bufferd_stats_free(bufferd_stats_t *s)
 {
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if circular buffer is not full
-    assert(b->size < b->max_size);
+    // check if stats is not null
+    assert(s != NULL);
 #endif
 
-    // get possible position for new value
-    float *data = bufferf_at(b, b->size);
-
-    // set data with value
-    *data = value;
-
-    // increment the circular buffer size
-    b->size++;
+    bufferd_free(&s->window);
+    bufferd_stats_clear(s);
 }
 
-void bufferf_pop_front(bufferf_t *b, float *value)
+// Two pass mean and m2 over the current window, O(n)
+void bufferd_stats_recompute(bufferd_stats_t *s)
 {
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-
-    // check if circular buffer is not empty
-    assert(b->size > 0);
+    // check if stats is not null
+    assert(s != NULL);
 #endif
 
-    // get possible position for first value
-    float *data = bufferf_at(b, 0);
-
-    // sets value from first element in the circular buffer
-    if (value != NULL)
+    bufferd_t *b = &s->window;
+    if (b->size == 0)
     {
-        *value = *data;
+        s->mean = 0.0;
+        s->m2 = 0.0;
+        return;
     }
 
-    // decrement the circular buffer size
-    b->size--;
-
-    // move buffer cursor
-    b->cur = (b->cur + 1) % b->max_size;
-}
-
-void bufferf_print(bufferf_t *b)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
-#endif
+    // the window is split in two contiguous spans
+    const double *p1, *p2;
+    size_t n1, n2;
+    bufferd_segments(b, &p1, &n1, &p2, &n2);
 
-    printf("bufferf:");
-    for (size_t p = 0; p < b->size; ++p)
+    double mean = (simd_sumd(p1, n1) + simd_sumd(p2, n2)) / (double)b->size;
+    double m2 = 0.0;
+    for (size_t p = 0; p < n1; ++p)
+    {
+        double d = p1[p] - mean;
+        m2 += d * d;
+    }
+    for (size_t p = 0; p < n2; ++p)
     {
-        printf(" %f", bufferf_get(b, p));
+        double d = p2[p] - mean;
+        m2 += d * d;
     }
-    printf("\n");
+
+    s->mean = mean;
+    s->m2 = m2;
+    s->count = 0;
 }
 
-void bufferf_push_and_pop(bufferf_t *b, float push_value, float *pop_value)
+// Pushes value into the window (evicting the oldest sample when full)
+// and reports the window mean and population variance (any of them can be NULL).
+void bufferd_stats_push(bufferd_stats_t *s, double value, double *avg, double *variance)
 {
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+    // check if stats is not null
+    assert(s != NULL);
 #endif
 
-    // pop front before overflowing
-    bufferf_pop_front(b, pop_value);
-
-    // push back after removing first element
-    bufferf_push_back(b, push_value);
-}
-
-void bufferf_avgi(bufferf_t *b, int *avg)
-{
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+    bufferd_t *b = &s->window;
+    if (b->size < b->max_size)
+    {
+        // growing window: Welford add
+        bufferd_push_back(b, value);
+        double d = value - s->mean;
+        s->mean += d / (double)b->size;
+        s->m2 += d * (value - s->mean);
+    }
+    else
+    {
+        // full window: the evicted value is replaced by the new one
+        double evicted;
+        bufferd_push_and_pop(b, value, &evicted);
+        double old_mean = s->mean;
+        s->mean += divisor_scale(&b->divisor, value - evicted);
+        s->m2 += (value - evicted) * (value - s->mean + evicted - old_mean);
+    }
 
-    // check if avg return is not null
-    assert(avg != NULL);
+#if CIRCULAR_VARIANCE_RESYNC > 0
+    if (++s->count >= CIRCULAR_VARIANCE_RESYNC)
+    {
+        bufferd_stats_recompute(s);
+    }
 #endif
 
-    int acc = 0;
-    for (size_t p = 0; p < b->size; ++p)
+    if (avg != NULL)
     {
-        acc += (int) bufferf_get(b, p);
+        *avg = s->mean;
+    }
+    if (variance != NULL)
+    {
+        // rounding can leave m2 slightly negative on a constant window
+        *variance = (s->m2 > 0.0) ? bufferd_scale(b, s->m2) : 0.0;
     }
-    *avg = acc / b->size;
 }
 
-void bufferf_avgd(bufferf_t *b, double *avg)
+// Population variance of the window in O(1)
+double bufferd_stats_variance(bufferd_stats_t *s)
 {
 #ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+    // check if stats is not null
+    assert(s != NULL);
 
-    // check if avg return is not null
-    assert(avg != NULL);
+    // check if window is not empty
+    assert(s->window.size > 0);
 #endif
 
-    double acc = 0.0;
-    for (size_t p = 0; p < b->size; ++p)
-    {
-        acc += (double)bufferf_get(b, p);
-    }
-    *avg = acc / ((double)b->size);
+    return (s->m2 > 0.0) ? bufferd_scale(&s->window, s->m2) : 0.0;
 }
 
-void bufferf_avgf(bufferf_t *b, float *avg)
+// Population standard deviation of the window in O(1)
+double bufferd_stats_stddev(bufferd_stats_t *s)
 {
-#ifndef NO_ASSERT
-    // check if buffer is not null
-    assert(b != NULL);
+    return sqrt(bufferd_stats_variance(s));
+}
 
-    // check if avg return is not null
-    assert(avg != NULL);
-#endif
 
-    float acc = 0.0f;
-    for (size_t p = 0; p < b->size; ++p)
-    {
-        acc += (float)bufferf_get(b, p);
-    }
-    *avg = acc / ((float)b->size);
-}
\ No newline at end of file
+/******************************************************************************************
+ *                                                                                        *
+ *                                  FLOAT  VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+CIRCULAR_DEFINE(bufferf, float)
+CIRCULAR_DEFINE_MIRROR(bufferf_mirror, float)
+
+CIRCULAR_DEFINE_MINMAX(bufferf_minmax, bufferf, float)
\ No newline at end of file
@@ -20,4 +20,14 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 #pragma once
-#include <circular_buffer.h>
\ No newline at end of file
+#include <circular_buffer.h>
+#include <order_statistics.h>
+#include <quantile_sketch.h>
+#include <multi_window.h>
+#include <buffer_bank.h>
+#include <spsc_buffer.h>
+#include <stream_reader.h>
+#include <result_sink.h>
+#include <ewma.h>
+#include <fir_filter.h>
+#include <pyramid.h>
\ No newline at end of file
@@ -22,6 +22,18 @@
 #pragma once
 #define BSZM 4
 #define WINDOW_SIZE 3
+#define BATCH_SIZE 4
+#define INPUT_RANGE (1 << 12) // input samples are in [0, INPUT_RANGE)
+#define INPUT_SEED 1           // default seed of the input generator
+#define SKETCH_ALPHA 0.01      // quantile sketch relative error
+#define MULTI_WINDOW_SIZES {2, 3, 4}
+#define PYRAMID_WINDOWS {4, 3, 2} // ring size of each pyramid level
+#define PYRAMID_FACTORS {1, 2, 3} // decimation from the previous level (1 for the raw level)
+#define BANK_CHANNELS 2
+#define SPSC_CAPACITY 8
+#define PARALLEL_THREADS 3 // 0 uses every online core
+#define STREAM_CHUNK 4      // samples per read() of the streaming reader (two chunks are allocated)
+#define SINK_BUFFER 4096    // bytes of the result file buffer (multiple of 4096)
 #define BENCHMARK
 
 #ifdef BENCHMARK
@@ -30,6 +42,42 @@
 
 #define WINDOW_SIZE 128
 
+#undef BATCH_SIZE
+
+#define BATCH_SIZE 4096
+
+#undef MULTI_WINDOW_SIZES
+
+#define MULTI_WINDOW_SIZES {8, 32, 128, 1024}
+
+#undef PYRAMID_WINDOWS
+
+#define PYRAMID_WINDOWS {60, 60, 24}
+
+#undef PYRAMID_FACTORS
+
+#define PYRAMID_FACTORS {1, 60, 60}
+
+#undef BANK_CHANNELS
+
+#define BANK_CHANNELS 1024
+
+#undef SPSC_CAPACITY
+
+#define SPSC_CAPACITY (16 * BATCH_SIZE)
+
+#undef PARALLEL_THREADS
+
+#define PARALLEL_THREADS 0
+
+#undef STREAM_CHUNK
+
+#define STREAM_CHUNK (256 * 1024)
+
+#undef SINK_BUFFER
+
+#define SINK_BUFFER (1 << 20)
+
 // 1GB
 // #define BENCHMARK_SIZE 1024*1024*1024
 
@@ -0,0 +1,74 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+
+// Division by a runtime constant (e.g. the window size) without a division instruction.
+// Integers use a multiply-shift magic number (Granlund-Montgomery, as in libdivide):
+// for 0 <= n < 2^63 and l = ceil(log2(d)), m = floor(2^(63 + l) / d) + 1 fits in 64 bits
+// and n / d == (n * m) >> (63 + l) exactly, the product is 128 bits wide.
+// Negative sums are divided by magnitude, so the result truncates toward zero like the C division.
+// Floating point averages multiply by the reciprocal instead.
+typedef struct divisor_st
+{
+    size_t d;                 // divisor
+    unsigned long long magic; // m
+    unsigned int shift;       // 63 + l
+    double reciprocal;        // 1 / d
+} divisor_t;
+
+void divisor_init(divisor_t *v, size_t d)
+{
+    v->d = (d > 0) ? d : 1;
+    v->reciprocal = 1.0 / (double)v->d;
+
+    unsigned int l = 0;
+    while (l < 64 && ((size_t)1 << l) < v->d)
+    {
+        l++;
+    }
+    v->shift = 63 + l;
+#ifdef __SIZEOF_INT128__
+    v->magic = (unsigned long long)((((unsigned __int128)1 << v->shift) / v->d) + 1);
+#else
+    v->magic = 0;
+#endif
+}
+
+// n / d, truncated toward zero
+long long divisor_divide(const divisor_t *v, long long n)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned long long a = (n < 0) ? 0ULL - (unsigned long long)n : (unsigned long long)n;
+    long long q = (long long)(((unsigned __int128)a * v->magic) >> v->shift);
+    return (n < 0) ? -q : q;
+#else
+    // no 128 bits product, the compiler division it is
+    return n / (long long)v->d;
+#endif
+}
+
+// x / d, rounded through the reciprocal
+double divisor_scale(const divisor_t *v, double x)
+{
+    return x * v->reciprocal;
+}
@@ -0,0 +1,472 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Exponentially weighted moving averages (first-order IIR filters), O(1) memory per channel:
+// y[n] = y[n - 1] + alpha * (x[n] - y[n - 1]), no ring and no evicted sample to read.
+// An EWMA of alpha = 2 / (N + 1) has the same mean sample age as an N samples window.
+//
+// ewmai_t: integers, alpha = 2^-shift, the state keeps EWMA_FRACTION fractional bits (shifts and adds only).
+// ewmaf_t / ewmad_t: any first-order IIR y[n] = b0 * x[n] + b1 * x[n - 1] - a1 * y[n - 1],
+//     ewma*_init sets the EWMA coefficients (b0 = alpha, b1 = 0, a1 = alpha - 1).
+// ewmai_bank_t / ewmaf_bank_t: one EWMA per channel, the channels are updated in one vectorizable loop.
+// The first sample initializes the state, so there is no ramp up from 0.
+
+// Fractional bits of the ewmai_t state
+#define EWMA_FRACTION 16
+
+// Shift of the power of two alpha closest to 2 / (window + 1)
+unsigned int ewma_shift(size_t window)
+{
+    unsigned int shift = 0;
+    // 2^shift closest to (window + 1) / 2, in the log domain
+    while (shift < 30 && (double)((size_t)1 << (shift + 1)) <= sqrt(2.0) * (double)(window + 1) / 2.0)
+    {
+        shift++;
+    }
+    return shift;
+}
+
+// alpha of a window, 2 / (window + 1)
+double ewma_alpha(size_t window)
+{
+    return 2.0 / ((double)window + 1.0);
+}
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  INT32 VALUES                                          *
+ *                                                                                        *
+ ******************************************************************************************/
+typedef struct ewmai_st
+{
+    long long state;    // average << EWMA_FRACTION
+    unsigned int shift; // alpha = 2^-shift
+    int primed;         // the state holds at least one sample
+} ewmai_t;
+
+void ewmai_clear(ewmai_t *e)
+{
+#ifndef NO_ASSERT
+    // check if ewma is not null
+    assert(e != NULL);
+#endif
+
+    e->state = 0;
+    e->primed = 0;
+}
+
+void ewmai_init(ewmai_t *e, unsigned int shift)
+{
+#ifndef NO_ASSERT
+    // check if ewma is not null
+    assert(e != NULL);
+#endif
+
+    e->shift = shift;
+    ewmai_clear(e);
+}
+
+// Current average, rounded to the nearest integer
+int ewmai_value(ewmai_t *e)
+{
+    return (int)((e->state + (1LL << (EWMA_FRACTION - 1))) >> EWMA_FRACTION);
+}
+
+int ewmai_push(ewmai_t *e, int value)
+{
+    long long x = (long long)value * (1LL << EWMA_FRACTION);
+    if (!e->primed)
+    {
+        e->state = x;
+        e->primed = 1;
+    }
+    else
+    {
+        // arithmetic shift, the difference can be negative
+        e->state += (x - e->state) >> e->shift;
+    }
+    return ewmai_value(e);
+}
+
+// Filters n samples of src, out[i] is the average after src[i] (out can be NULL)
+void ewmai_push_many(ewmai_t *e, const int *src, size_t n, int *out)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    size_t i = 0;
+    if (!e->primed)
+    {
+        int first = ewmai_push(e, src[0]);
+        if (out != NULL)
+        {
+            out[0] = first;
+        }
+        i = 1;
+    }
+
+    // the state stays in a register
+    long long state = e->state;
+    const unsigned int shift = e->shift;
+    const long long half = 1LL << (EWMA_FRACTION - 1);
+    for (; i < n; ++i)
+    {
+        state += ((long long)src[i] * (1LL << EWMA_FRACTION) - state) >> shift;
+        if (out != NULL)
+        {
+            out[i] = (int)((state + half) >> EWMA_FRACTION);
+        }
+    }
+    e->state = state;
+}
+
+// One EWMA per channel with 64 bits fixed point states (same format as ewmai_t), updated together
+typedef struct ewmai_bank_st
+{
+    long long *state;   // average << EWMA_FRACTION of each channel
+    size_t channels;    // number of channels
+    unsigned int shift; // alpha = 2^-shift
+    int primed;         // the states hold at least one sample
+} ewmai_bank_t;
+
+void ewmai_bank_init(ewmai_bank_t *b, size_t channels, unsigned int shift)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+#endif
+
+    b->state = (long long *)calloc(channels, sizeof(long long));
+    b->channels = (b->state != NULL) ? channels : 0;
+    b->shift = shift;
+    b->primed = 0;
+}
+
+void ewmai_bank_free(ewmai_bank_t *b)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+#endif
+
+    free(b->state);
+    b->state = NULL;
+    b->channels = 0;
+}
+
+// Pushes samples[c] into every channel c and writes the averages in avg_out (can be NULL)
+void ewmai_bank_push(ewmai_bank_t *b, const int *samples, int *avg_out)
+{
+    long long *state = b->state;
+    const size_t channels = b->channels;
+    const unsigned int shift = b->shift;
+    if (!b->primed)
+    {
+        for (size_t c = 0; c < channels; ++c)
+        {
+            state[c] = (long long)samples[c] * (1LL << EWMA_FRACTION);
+        }
+        b->primed = 1;
+    }
+    else
+    {
+        // shifts, subtractions and additions only, one SIMD pass over 64 bits lanes
+        for (size_t c = 0; c < channels; ++c)
+        {
+            state[c] += ((long long)samples[c] * (1LL << EWMA_FRACTION) - state[c]) >> shift;
+        }
+    }
+
+    if (avg_out != NULL)
+    {
+        for (size_t c = 0; c < channels; ++c)
+        {
+            avg_out[c] = (int)((state[c] + (1LL << (EWMA_FRACTION - 1))) >> EWMA_FRACTION);
+        }
+    }
+}
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  DOUBLE VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+typedef struct ewmad_st
+{
+    double b0;  // input coefficient
+    double b1;  // previous input coefficient
+    double a1;  // previous output coefficient (y[n] = b0 * x[n] + b1 * x[n - 1] - a1 * y[n - 1])
+    double x1;  // previous input
+    double y1;  // previous output
+    int primed; // the filter has seen at least one sample
+} ewmad_t;
+
+void ewmad_clear(ewmad_t *e)
+{
+#ifndef NO_ASSERT
+    // check if filter is not null
+    assert(e != NULL);
+#endif
+
+    e->x1 = 0.0;
+    e->y1 = 0.0;
+    e->primed = 0;
+}
+
+// Any first-order IIR filter
+void ewmad_init_iir(ewmad_t *e, double b0, double b1, double a1)
+{
+#ifndef NO_ASSERT
+    // check if filter is not null
+    assert(e != NULL);
+#endif
+
+    e->b0 = b0;
+    e->b1 = b1;
+    e->a1 = a1;
+    ewmad_clear(e);
+}
+
+// EWMA of weight alpha for the newest sample
+void ewmad_init(ewmad_t *e, double alpha)
+{
+    ewmad_init_iir(e, alpha, 0.0, alpha - 1.0);
+}
+
+double ewmad_value(ewmad_t *e)
+{
+    return e->y1;
+}
+
+// Starts from the steady state of a constant input equal to the first sample (the sample itself for an integrator)
+void ewmad_prime(ewmad_t *e, double value)
+{
+    double gain = 1.0 + e->a1;
+    e->x1 = value;
+    e->y1 = (gain != 0.0) ? value * (e->b0 + e->b1) / gain : value;
+    e->primed = 1;
+}
+
+double ewmad_push(ewmad_t *e, double value)
+{
+    if (!e->primed)
+    {
+        ewmad_prime(e, value);
+    }
+    double y = e->b0 * value + e->b1 * e->x1 - e->a1 * e->y1;
+    e->x1 = value;
+    e->y1 = y;
+    return y;
+}
+
+// Filters n samples of src, out[i] is the output after src[i] (out can be NULL)
+void ewmad_push_many(ewmad_t *e, const double *src, size_t n, double *out)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    if (!e->primed)
+    {
+        ewmad_prime(e, src[0]);
+    }
+
+    // the state stays in registers
+    const double b0 = e->b0, b1 = e->b1, a1 = e->a1;
+    double x1 = e->x1, y1 = e->y1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        y1 = b0 * src[i] + b1 * x1 - a1 * y1;
+        x1 = src[i];
+        if (out != NULL)
+        {
+            out[i] = y1;
+        }
+    }
+    e->x1 = x1;
+    e->y1 = y1;
+}
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  FLOAT  VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+typedef struct ewmaf_st
+{
+    float b0;   // input coefficient
+    float b1;   // previous input coefficient
+    float a1;   // previous output coefficient (y[n] = b0 * x[n] + b1 * x[n - 1] - a1 * y[n - 1])
+    float x1;   // previous input
+    float y1;   // previous output
+    int primed; // the filter has seen at least one sample
+} ewmaf_t;
+
+void ewmaf_clear(ewmaf_t *e)
+{
+#ifndef NO_ASSERT
+    // check if filter is not null
+    assert(e != NULL);
+#endif
+
+    e->x1 = 0.0f;
+    e->y1 = 0.0f;
+    e->primed = 0;
+}
+
+// Any first-order IIR filter
+void ewmaf_init_iir(ewmaf_t *e, float b0, float b1, float a1)
+{
+#ifndef NO_ASSERT
+    // check if filter is not null
+    assert(e != NULL);
+#endif
+
+    e->b0 = b0;
+    e->b1 = b1;
+    e->a1 = a1;
+    ewmaf_clear(e);
+}
+
+// EWMA of weight alpha for the newest sample
+void ewmaf_init(ewmaf_t *e, float alpha)
+{
+    ewmaf_init_iir(e, alpha, 0.0f, alpha - 1.0f);
+}
+
+float ewmaf_value(ewmaf_t *e)
+{
+    return e->y1;
+}
+
+// Starts from the steady state of a constant input equal to the first sample (the sample itself for an integrator)
+void ewmaf_prime(ewmaf_t *e, float value)
+{
+    float gain = 1.0f + e->a1;
+    e->x1 = value;
+    e->y1 = (gain != 0.0f) ? value * (e->b0 + e->b1) / gain : value;
+    e->primed = 1;
+}
+
+float ewmaf_push(ewmaf_t *e, float value)
+{
+    if (!e->primed)
+    {
+        ewmaf_prime(e, value);
+    }
+    float y = e->b0 * value + e->b1 * e->x1 - e->a1 * e->y1;
+    e->x1 = value;
+    e->y1 = y;
+    return y;
+}
+
+// Filters n samples of src, out[i] is the output after src[i] (out can be NULL)
+void ewmaf_push_many(ewmaf_t *e, const float *src, size_t n, float *out)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    if (!e->primed)
+    {
+        ewmaf_prime(e, src[0]);
+    }
+
+    // the state stays in registers
+    const float b0 = e->b0, b1 = e->b1, a1 = e->a1;
+    float x1 = e->x1, y1 = e->y1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        y1 = b0 * src[i] + b1 * x1 - a1 * y1;
+        x1 = src[i];
+        if (out != NULL)
+        {
+            out[i] = y1;
+        }
+    }
+    e->x1 = x1;
+    e->y1 = y1;
+}
+
+// One float EWMA per channel, updated together
+typedef struct ewmaf_bank_st
+{
+    float *state;    // average of each channel
+    size_t channels; // number of channels
+    float alpha;     // weight of the newest sample
+    int primed;      // the states hold at least one sample
+} ewmaf_bank_t;
+
+void ewmaf_bank_init(ewmaf_bank_t *b, size_t channels, float alpha)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+#endif
+
+    b->state = (float *)calloc(channels, sizeof(float));
+    b->channels = (b->state != NULL) ? channels : 0;
+    b->alpha = alpha;
+    b->primed = 0;
+}
+
+void ewmaf_bank_free(ewmaf_bank_t *b)
+{
+#ifndef NO_ASSERT
+    // check if bank is not null
+    assert(b != NULL);
+#endif
+
+    free(b->state);
+    b->state = NULL;
+    b->channels = 0;
+}
+
+// Pushes samples[c] into every channel c, the averages are b->state
+void ewmaf_bank_push(ewmaf_bank_t *b, const float *samples)
+{
+    float *state = b->state;
+    const size_t channels = b->channels;
+    const float alpha = b->alpha;
+    if (!b->primed)
+    {
+        memcpy(state, samples, channels * sizeof(float));
+        b->primed = 1;
+        return;
+    }
+
+    // one SIMD pass, the channels are independent
+    for (size_t c = 0; c < channels; ++c)
+    {
+        state[c] += alpha * (samples[c] - state[c]);
+    }
+}
@@ -0,0 +1,128 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// EWMA with alpha = 2^-shift, the power of two closest to 2 / (window_size + 1): O(1) memory whatever the window
+int main_ewma()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int *avg = (int *)malloc(BATCH_SIZE * sizeof(int)); // averages of one block
+    ewmai_t e;                                           // fixed point EWMA
+    ewmai_init(&e, ewma_shift(window_size));             // alpha matching window_size
+
+    for (size_t i = 0; i < input_vector_size; i += BATCH_SIZE)
+    {
+        size_t n = input_vector_size - i;
+        if (n > BATCH_SIZE)
+        {
+            n = BATCH_SIZE;
+        }
+        ewmai_push_many(&e, input_vector + i, n, avg); // O(n), shifts and adds
+        sink_write(&results, avg, n);
+        if (verbose)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                printf("avg: %d\n", avg[j]);
+            }
+        }
+    }
+
+    free(avg);
+
+    return 0;
+}
+
+// EWMA with the exact alpha = 2 / (window_size + 1) in single precision
+int main_ewma_float()
+{
+    fprintf(stderr, "%s\n", __func__);
+    float *x = (float *)malloc(BATCH_SIZE * sizeof(float)); // samples of one block
+    float *y = (float *)malloc(BATCH_SIZE * sizeof(float)); // averages of one block
+    int *avg = (int *)malloc(BATCH_SIZE * sizeof(int));     // rounded averages of one block
+    ewmaf_t e;                                              // first-order IIR filter
+    ewmaf_init(&e, (float)ewma_alpha(window_size));         // EWMA coefficients matching window_size
+
+    for (size_t i = 0; i < input_vector_size; i += BATCH_SIZE)
+    {
+        size_t n = input_vector_size - i;
+        if (n > BATCH_SIZE)
+        {
+            n = BATCH_SIZE;
+        }
+        for (size_t j = 0; j < n; ++j)
+        {
+            x[j] = (float)input_vector[i + j];
+        }
+        ewmaf_push_many(&e, x, n, y); // O(n), two multiplications per sample
+        for (size_t j = 0; j < n; ++j)
+        {
+            avg[j] = (int)lrintf(y[j]);
+        }
+        sink_write(&results, avg, n);
+        if (verbose)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                printf("avg: %f\n", y[j]);
+            }
+        }
+    }
+
+    free(avg);
+    free(y);
+    free(x);
+
+    return 0;
+}
+
+// The input is read as BANK_CHANNELS interleaved channels, like main_bank, with one EWMA per channel
+int main_ewma_bank()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int *avg = (int *)malloc(BANK_CHANNELS * sizeof(int));       // averages of every channel
+    ewmai_bank_t b;                                               // bank struct
+    ewmai_bank_init(&b, BANK_CHANNELS, ewma_shift(window_size)); // BANK_CHANNELS channels, alpha matching window_size
+
+    for (size_t i = 0; i + BANK_CHANNELS <= input_vector_size; i += BANK_CHANNELS)
+    {
+        ewmai_bank_push(&b, input_vector + i, avg); // O(channels), SIMD
+        if (verbose)
+        {
+            printf("avg:");
+            for (size_t c = 0; c < BANK_CHANNELS; ++c)
+            {
+                printf(" %d", avg[c]);
+            }
+            printf("\n");
+        }
+    }
+
+    ewmai_bank_free(&b);
+    free(avg);
+
+    return 0;
+}
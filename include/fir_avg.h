@@ -0,0 +1,178 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// Hann weighted average of the last window_size samples, one ring update and two dot products per sample
+int main_fir()
+{
+    fprintf(stderr, "%s\n", __func__);
+    float avg = 0.0f;
+    float *h = (float *)malloc(window_size * sizeof(float)); // filter coefficients
+    if (h == NULL)
+    {
+        fprintf(stderr, "fir: cannot allocate %zu taps\n", window_size);
+        return 1;
+    }
+    fir_window_hann(h, window_size); // window_size taps
+    firf_t f;                        // FIR engine over a float ring
+    firf_init(&f, h, window_size);   // the taps are copied
+    if (f.length == 0)
+    {
+        fprintf(stderr, "fir: cannot allocate a window of %zu samples\n", window_size);
+        free(h);
+        return 1;
+    }
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        avg = firf_push(&f, (float)input_vector[i]); // O(n), SIMD
+        sink_put(&results, (int)lrintf(avg));
+        if (verbose)
+        {
+            printf("avg: %f\n", avg);
+        }
+    }
+
+    firf_free(&f);
+    free(h);
+
+    return 0;
+}
+
+// Same filter, BATCH_SIZE samples at a time with the block convolution
+int main_fir_block()
+{
+    fprintf(stderr, "%s\n", __func__);
+    float *x = (float *)malloc(BATCH_SIZE * sizeof(float));  // samples of one block
+    float *y = (float *)malloc(BATCH_SIZE * sizeof(float));  // averages of one block
+    int *avg = (int *)malloc(BATCH_SIZE * sizeof(int));      // rounded averages of one block
+    float *h = (float *)malloc(window_size * sizeof(float)); // filter coefficients
+    if (x == NULL || y == NULL || avg == NULL || h == NULL)
+    {
+        fprintf(stderr, "fir_block: cannot allocate %d sample blocks and %zu taps\n", BATCH_SIZE, window_size);
+        free(h);
+        free(avg);
+        free(y);
+        free(x);
+        return 1;
+    }
+    fir_window_hann(h, window_size); // window_size taps
+    firf_t f;                        // FIR engine over a float ring
+    firf_init(&f, h, window_size);   // the taps are copied
+    if (f.length == 0)
+    {
+        fprintf(stderr, "fir_block: cannot allocate a window of %zu samples\n", window_size);
+        free(h);
+        free(avg);
+        free(y);
+        free(x);
+        return 1;
+    }
+
+    for (size_t i = 0; i < input_vector_size; i += BATCH_SIZE)
+    {
+        size_t n = input_vector_size - i;
+        if (n > BATCH_SIZE)
+        {
+            n = BATCH_SIZE;
+        }
+        for (size_t j = 0; j < n; ++j)
+        {
+            x[j] = (float)input_vector[i + j];
+        }
+        firf_filter_block(&f, x, n, y); // O(n) per sample, SIMD across the outputs
+        for (size_t j = 0; j < n; ++j)
+        {
+            avg[j] = (int)lrintf(y[j]);
+        }
+        sink_write(&results, avg, n);
+        if (verbose)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                printf("avg: %f\n", y[j]);
+            }
+        }
+    }
+
+    firf_free(&f);
+    free(h);
+    free(avg);
+    free(y);
+    free(x);
+
+    return 0;
+}
+
+// Reference implementation, reading every tap through bufferf_get (a modulo per tap)
+int main_fir_naive()
+{
+    fprintf(stderr, "%s\n", __func__);
+    float avg = 0.0f;
+    float *h = (float *)malloc(window_size * sizeof(float)); // filter coefficients
+    if (h == NULL)
+    {
+        fprintf(stderr, "fir_naive: cannot allocate %zu taps\n", window_size);
+        return 1;
+    }
+    fir_window_hann(h, window_size); // window_size taps
+    bufferf_t b;                     // buffer struct
+    bufferf_init(&b, window_size);   // initialize buffer with window_size as maximum size
+    if (!bufferf_has_data(&b))
+    {
+        fprintf(stderr, "fir_naive: cannot allocate a window of %zu samples\n", window_size);
+        free(h);
+        return 1;
+    }
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        if (b.size < b.max_size)
+        {
+            bufferf_push_back(&b, (float)input_vector[i]); // O(1)
+        }
+        else
+        {
+            bufferf_push_and_pop(&b, (float)input_vector[i], NULL); // O(1)
+        }
+
+        avg = 0.0f;
+        for (size_t k = 0; k < b.size; ++k) // O(n)
+        {
+            avg += h[k] * bufferf_get(&b, b.size - 1 - k);
+        }
+        sink_put(&results, (int)lrintf(avg));
+        if (verbose)
+        {
+            printf("avg: %f\n", avg);
+        }
+    }
+
+    bufferf_free(&b);
+    free(h);
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <simd_kernels.h>
+#include <circular_buffer.h>
+
+// FIR filters (weighted moving averages) over a circular window of float samples:
+// y[n] = sum of h[k] * x[n - k] for k < length, with the samples older than the first one taken as 0.
+// The taps are stored oldest first, so an output is at most two SIMD dot products
+// against the two contiguous spans of the ring, without any modulo per tap.
+// firf_filter_block convolves a whole batch instead: the history and the batch are laid out
+// in one linear scratch and tiles of outputs accumulate in registers (no horizontal sums).
+
+// Outputs computed per pass of firf_filter_block
+#define FIR_BLOCK 1024
+
+typedef struct firf_st
+{
+    float *taps;    // h[length - 1 - j], the weight of the j-th oldest sample of a full window
+    size_t length;  // number of taps
+    bufferf_t ring; // last length samples
+    float *scratch; // length - 1 samples of history followed by FIR_BLOCK samples
+} firf_t;
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  WINDOWS                                               *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// Scales the coefficients so they sum to 1 (unit gain, the output is a weighted average)
+void fir_normalize(float *coeffs, size_t length)
+{
+    double sum = 0.0;
+    for (size_t k = 0; k < length; ++k)
+    {
+        sum += coeffs[k];
+    }
+    if (sum == 0.0)
+    {
+        return;
+    }
+    for (size_t k = 0; k < length; ++k)
+    {
+        coeffs[k] = (float)(coeffs[k] / sum);
+    }
+}
+
+// Same weight for every sample, the plain moving average
+void fir_window_uniform(float *coeffs, size_t length)
+{
+    for (size_t k = 0; k < length; ++k)
+    {
+        coeffs[k] = 1.0f;
+    }
+    fir_normalize(coeffs, length);
+}
+
+// Weights rising linearly to the middle of the window then falling
+void fir_window_triangular(float *coeffs, size_t length)
+{
+    for (size_t k = 0; k < length; ++k)
+    {
+        size_t rise = k + 1;
+        size_t fall = length - k;
+        coeffs[k] = (float)(rise < fall ? rise : fall);
+    }
+    fir_normalize(coeffs, length);
+}
+
+// Raised cosine weights, without the zero weights at both ends
+void fir_window_hann(float *coeffs, size_t length)
+{
+    const double pi = 3.14159265358979323846;
+    for (size_t k = 0; k < length; ++k)
+    {
+        coeffs[k] = (float)(0.5 - 0.5 * cos(2.0 * pi * (double)(k + 1) / (double)(length + 1)));
+    }
+    fir_normalize(coeffs, length);
+}
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  FLOAT  VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// coeffs[k] is h[k], the weight of the sample pushed k samples before the newest one
+void firf_init(firf_t *f, const float *coeffs, size_t length)
+{
+#ifndef NO_ASSERT
+    // check if filter and coefficients are not null, with at least one tap
+    assert(f != NULL && coeffs != NULL && length > 0);
+#endif
+
+    f->taps = (float *)malloc(length * sizeof(float));
+    f->scratch = (float *)malloc((length + FIR_BLOCK) * sizeof(float));
+    bufferf_init(&f->ring, length);
+    if (f->taps == NULL || f->scratch == NULL || f->ring.max_size != length)
+    {
+        // the ring may have failed too, bufferf_free expects an allocated one
+        free(f->taps);
+        free(f->scratch);
+        if (bufferf_has_data(&f->ring))
+        {
+            bufferf_free(&f->ring);
+        }
+        f->taps = NULL;
+        f->scratch = NULL;
+        f->length = 0;
+        return;
+    }
+
+    // oldest first, in the order of the ring
+    for (size_t j = 0; j < length; ++j)
+    {
+        f->taps[j] = coeffs[length - 1 - j];
+    }
+    f->length = length;
+}
+
+void firf_clear(firf_t *f)
+{
+#ifndef NO_ASSERT
+    // check if filter is not null
+    assert(f != NULL);
+#endif
+
+    bufferf_clear(&f->ring);
+}
+
+void firf_free(firf_t *f)
+{
+#ifndef NO_ASSERT
+    // check if filter is not null
+    assert(f != NULL);
+#endif
+
+    // nothing is allocated after a failed firf_init
+    if (bufferf_has_data(&f->ring))
+    {
+        bufferf_free(&f->ring);
+    }
+    free(f->taps);
+    free(f->scratch);
+    f->taps = NULL;
+    f->scratch = NULL;
+    f->length = 0;
+}
+
+// Output for the samples currently in the ring, O(length) in two dot products
+float firf_output(firf_t *f)
+{
+    bufferf_t *b = &f->ring;
+
+    // a window still filling up meets the newest taps only
+    const float *taps = f->taps + (f->length - b->size);
+    const float *p1, *p2;
+    size_t n1, n2;
+    bufferf_segments(b, &p1, &n1, &p2, &n2);
+    return simd_dotf(p1, taps, n1) + simd_dotf(p2, taps + n1, n2);
+}
+
+float firf_push(firf_t *f, float value)
+{
+    if (f->ring.size < f->ring.max_size)
+    {
+        bufferf_push_back(&f->ring, value); // O(1)
+    }
+    else
+    {
+        bufferf_push_and_pop(&f->ring, value, NULL); // O(1)
+    }
+    return firf_output(f);
+}
+
+// Filters n samples of src, out[i] is the output right after src[i] was pushed
+// (same result as firf_push for each value, up to the rounding of the reassociated sums)
+void firf_filter_block(firf_t *f, const float *src, size_t n, float *out)
+{
+#ifndef NO_ASSERT
+    // check if filter, source and destination are not null
+    assert(f != NULL && ((src != NULL && out != NULL) || n == 0));
+#endif
+
+    const size_t history = f->length - 1;
+    bufferf_t *b = &f->ring;
+    for (size_t i = 0; i < n; i += FIR_BLOCK)
+    {
+        size_t m = n - i;
+        if (m > FIR_BLOCK)
+        {
+            m = FIR_BLOCK;
+        }
+
+        // history: the newest length - 1 samples of the ring, zero padded in front when it is not full yet
+        size_t kept = b->size < history ? b->size : history;
+        size_t pad = history - kept;
+        memset(f->scratch, 0, pad * sizeof(float));
+        bufferf_copy_out(b, b->size - kept, f->scratch + pad, kept);
+        memcpy(f->scratch + history, src + i, m * sizeof(float));
+
+        // out[t] = sum of taps[j] * scratch[t + j]
+        simd_convf(f->scratch, f->taps, f->length, out + i, m);
+
+        bufferf_push_many(b, src + i, m, NULL); // the ring keeps the last length samples
+    }
+}
@@ -0,0 +1,282 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <defines.h>
+
+// Parallel, reproducible input generator.
+// The input is cut in GENERATOR_CHUNK samples chunks, each with its own xoshiro256** state seeded
+// from (seed, chunk number) with SplitMix64, so the samples only depend on the seed, never on the
+// number of threads. Each chunk runs GENERATOR_LANES interleaved streams kept as separate arrays,
+// so the state update of the lanes is a plain loop the compiler vectorizes.
+
+#define GENERATOR_CHUNK (64 * 1024) // samples per independently seeded chunk
+#define GENERATOR_LANES 4           // interleaved xoshiro256** streams per chunk
+#define GENERATOR_BLOCK 256         // random words generated at once (multiple of GENERATOR_LANES)
+#define GENERATOR_STEP_LENGTH 4096  // samples per level of the step distribution
+#define GENERATOR_SPIKE_RATE 1024   // one sample in GENERATOR_SPIKE_RATE is a spike (power of two)
+
+typedef enum generator_distribution_en
+{
+    GENERATOR_UNIFORM,  // uniform in [0, INPUT_RANGE)
+    GENERATOR_GAUSSIAN, // normal around INPUT_RANGE / 2, INPUT_RANGE / 8 standard deviation
+    GENERATOR_STEP,     // a random level every GENERATOR_STEP_LENGTH samples, plus a little noise
+    GENERATOR_SPIKE,    // low noise with rare spikes near INPUT_RANGE
+    GENERATOR_DISTRIBUTIONS
+} generator_distribution_t;
+
+const char *generator_distribution_names[GENERATOR_DISTRIBUTIONS] = {"uniform", "gaussian", "step", "spike"};
+
+typedef struct generator_st
+{
+    uint64_t s0[GENERATOR_LANES]; // xoshiro256** state words of each lane
+    uint64_t s1[GENERATOR_LANES];
+    uint64_t s2[GENERATOR_LANES];
+    uint64_t s3[GENERATOR_LANES];
+} generator_t;
+
+// Distribution of a name, -1 when unknown
+int generator_distribution(const char *name)
+{
+    for (int d = 0; d < GENERATOR_DISTRIBUTIONS; ++d)
+    {
+        if (strcmp(name, generator_distribution_names[d]) == 0)
+        {
+            return d;
+        }
+    }
+    return -1;
+}
+
+uint64_t generator_splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Counter based: the n-th SplitMix64 output of seed, without going through the previous ones
+uint64_t generator_hash(uint64_t seed, uint64_t n)
+{
+    uint64_t state = seed + n * 0x9e3779b97f4a7c15ULL;
+    return generator_splitmix64(&state);
+}
+
+uint64_t generator_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+// Seeds the lanes of stream number stream (e.g. a chunk)
+void generator_seed(generator_t *g, uint64_t seed, uint64_t stream)
+{
+    uint64_t state = generator_hash(seed, stream);
+    for (size_t l = 0; l < GENERATOR_LANES; ++l)
+    {
+        g->s0[l] = generator_splitmix64(&state);
+        g->s1[l] = generator_splitmix64(&state);
+        g->s2[l] = generator_splitmix64(&state);
+        g->s3[l] = generator_splitmix64(&state);
+    }
+}
+
+// Writes n random words (n multiple of GENERATOR_LANES), lane l gives out[l], out[l + LANES], ...
+void generator_next(generator_t *g, uint64_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i += GENERATOR_LANES)
+    {
+        for (size_t l = 0; l < GENERATOR_LANES; ++l)
+        {
+            uint64_t t = g->s1[l] << 17;
+            out[i + l] = generator_rotl(g->s1[l] * 5, 7) * 9;
+            g->s2[l] ^= g->s0[l];
+            g->s3[l] ^= g->s1[l];
+            g->s1[l] ^= g->s2[l];
+            g->s0[l] ^= g->s3[l];
+            g->s2[l] ^= t;
+            g->s3[l] = generator_rotl(g->s3[l], 45);
+        }
+    }
+}
+
+// Uniform integer in [0, range) from the high half of a random word
+int generator_below(uint64_t x, uint64_t range)
+{
+    return (int)(((x >> 32) * range) >> 32);
+}
+
+// Uniform double in [0, 1) from the 53 high bits of a random word
+double generator_unit(uint64_t x)
+{
+    return (double)(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int generator_clamp(double value)
+{
+    if (value < 0.0)
+    {
+        return 0;
+    }
+    if (value > (double)(INPUT_RANGE - 1))
+    {
+        return INPUT_RANGE - 1;
+    }
+    return (int)lrint(value);
+}
+
+// Writes the samples [first, first + n) of the input, from random words x (n of them)
+void generator_map(generator_distribution_t distribution, uint64_t seed, size_t first, const uint64_t *x, int *dst, size_t n)
+{
+    switch (distribution)
+    {
+    case GENERATOR_UNIFORM:
+        for (size_t i = 0; i < n; ++i)
+        {
+            dst[i] = generator_below(x[i], INPUT_RANGE);
+        }
+        break;
+    case GENERATOR_GAUSSIAN:
+        // Box-Muller, two samples from the words of two samples (n is even except at the very end)
+        for (size_t i = 0; i < n; i += 2)
+        {
+            uint64_t y = (i + 1 < n) ? x[i + 1] : generator_hash(seed, first + i);
+            double r = sqrt(-2.0 * log(1.0 - generator_unit(x[i])));
+            double theta = 6.283185307179586 * generator_unit(y);
+            dst[i] = generator_clamp(INPUT_RANGE / 2.0 + INPUT_RANGE / 8.0 * r * cos(theta));
+            if (i + 1 < n)
+            {
+                dst[i + 1] = generator_clamp(INPUT_RANGE / 2.0 + INPUT_RANGE / 8.0 * r * sin(theta));
+            }
+        }
+        break;
+    case GENERATOR_STEP:
+        for (size_t i = 0; i < n; ++i)
+        {
+            // the level only depends on the step number, whatever the chunk boundaries
+            int level = generator_below(generator_hash(~seed, (first + i) / GENERATOR_STEP_LENGTH), INPUT_RANGE);
+            int noise = generator_below(x[i], INPUT_RANGE / 32 + 1) - INPUT_RANGE / 64;
+            dst[i] = generator_clamp((double)(level + noise));
+        }
+        break;
+    case GENERATOR_SPIKE:
+        for (size_t i = 0; i < n; ++i)
+        {
+            // the low bits decide the spike, the high bits the value
+            int spike = (x[i] & (GENERATOR_SPIKE_RATE - 1)) == 0;
+            int noise = generator_below(x[i], INPUT_RANGE / 16);
+            dst[i] = spike ? INPUT_RANGE - 1 - noise / 4 : noise;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Generates the samples of chunk c
+void generator_chunk(generator_distribution_t distribution, uint64_t seed, size_t c, int *dst, size_t size)
+{
+    generator_t g;
+    generator_seed(&g, seed, c);
+
+    uint64_t x[GENERATOR_BLOCK];
+    size_t end = (size - c * GENERATOR_CHUNK < GENERATOR_CHUNK) ? size : (c + 1) * GENERATOR_CHUNK;
+    for (size_t i = c * GENERATOR_CHUNK; i < end; i += GENERATOR_BLOCK)
+    {
+        size_t n = (end - i < GENERATOR_BLOCK) ? end - i : GENERATOR_BLOCK;
+        generator_next(&g, x, GENERATOR_BLOCK);
+        generator_map(distribution, seed, i, x, dst + i, n);
+    }
+}
+
+typedef struct generator_job_st
+{
+    generator_distribution_t distribution; // distribution of the samples
+    uint64_t seed;                         // input seed
+    int *dst;                              // the whole input
+    size_t size;                           // input size
+    size_t first;                          // first chunk of the job
+    size_t step;                           // chunks between two chunks of the job (the number of jobs)
+    int threaded;                          // runs on its own thread (to join), 0 when it ran on the caller
+} generator_job_t;
+
+void *generator_worker(void *arg)
+{
+    generator_job_t *job = (generator_job_t *)arg;
+    size_t chunks = (job->size + GENERATOR_CHUNK - 1) / GENERATOR_CHUNK;
+    for (size_t c = job->first; c < chunks; c += job->step)
+    {
+        generator_chunk(job->distribution, job->seed, c, job->dst, job->size);
+    }
+    return NULL;
+}
+
+// Fills dst with size samples of the distribution using threads threads,
+// the samples only depend on (distribution, seed)
+void generator_fill(int *dst, size_t size, generator_distribution_t distribution, uint64_t seed, size_t threads)
+{
+    size_t chunks = (size + GENERATOR_CHUNK - 1) / GENERATOR_CHUNK;
+    if (threads > chunks)
+    {
+        threads = chunks;
+    }
+    if (threads <= 1)
+    {
+        generator_job_t job = {distribution, seed, dst, size, 0, 1, 0};
+        generator_worker(&job);
+        return;
+    }
+
+    pthread_t *tid = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    generator_job_t *jobs = (generator_job_t *)malloc(threads * sizeof(generator_job_t));
+    if (tid == NULL || jobs == NULL)
+    {
+        // the samples do not depend on the number of threads
+        free(jobs);
+        free(tid);
+        generator_fill(dst, size, distribution, seed, 1);
+        return;
+    }
+    for (size_t t = 0; t < threads; ++t)
+    {
+        generator_job_t job = {distribution, seed, dst, size, t, threads, 0};
+        jobs[t] = job;
+        jobs[t].threaded = (pthread_create(&tid[t], NULL, generator_worker, &jobs[t]) == 0);
+        if (!jobs[t].threaded)
+        {
+            // no thread for this job (e.g. EAGAIN), its chunks are filled here
+            generator_worker(&jobs[t]);
+        }
+    }
+    for (size_t t = 0; t < threads; ++t)
+    {
+        if (jobs[t].threaded)
+        {
+            pthread_join(tid[t], NULL);
+        }
+    }
+    free(jobs);
+    free(tid);
+}
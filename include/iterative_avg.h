@@ -21,19 +21,18 @@
 // SOFTWARE.
 #pragma once
 #include <defines.h>
+#include <settings.h>
 #include <alloc_vec.h>
 #include <data_structures.h>
 
 int main_iterative()
 {
-    printf("%s\n", __func__);
-    int last_element = 0;
-    int avg_acc = 0;
-    int avg_qnt = 0;
-    bufferi_t b;                   // buffer struct
-    bufferi_init(&b, WINDOW_SIZE); // initialize buffer with WINDOW_SIZE as maximum size
-
-    for (int i = 0; i < input_vector_size; ++i)
+    fprintf(stderr, "%s\n", __func__);
+    int avg = 0;
+    bufferi_t b;                        // buffer struct, keeps the running sum of the window
+    bufferi_init_pow2(&b, window_size); // initialize buffer with window_size as maximum size (mask indexing)
+
+    for (size_t i = 0; i < input_vector_size; ++i)
     {
         if (b.size < b.max_size)
         {
@@ -41,17 +40,15 @@ int main_iterative()
         }
         else
         {
-            bufferi_push_and_pop(&b, input_vector[i], &last_element); // O(1)
-            avg_acc -= last_element;                                  // O(1)
-            // printf("subtract %d == %d\n", last_element, avg_acc);
+            bufferi_push_and_pop(&b, input_vector[i], NULL); // O(1)
+        }
+        avg = bufferi_mean(&b); // O(1)
+        sink_put(&results, avg);
+        if (verbose)
+        {
+            bufferi_print(&b);
+            printf("avg: %d\n", avg);
         }
-        avg_acc += input_vector[i];
-        // printf("add %d == %d\n", input_vector[i], avg_acc);
-        avg_qnt = b.size;
-#ifndef BENCHMARK
-        bufferi_print(&b);
-        printf("avg: %d\n", avg_acc / avg_qnt); // O(1)
-#endif
     }
 
     bufferi_free(&b);
@@ -0,0 +1,95 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+int main_median_skiplist();
+
+// Median and percentiles with the counting structure, sized from the input range
+// (inputs wider than ORDER_MAX_RANGE values use the skiplist)
+int main_median()
+{
+    int min_value = 0;
+    int max_value = 0;
+    input_vector_bounds(&min_value, &max_value);
+    if ((long long)max_value - (long long)min_value + 1 > ORDER_MAX_RANGE)
+    {
+        fprintf(stderr, "%s: input range [%d, %d] too wide for the counting structure, using the skiplist\n",
+                __func__, min_value, max_value);
+        return main_median_skiplist();
+    }
+
+    fprintf(stderr, "%s\n", __func__);
+    int median = 0;
+    int p90 = 0;
+    int p99 = 0;
+    bufferi_order_t o;                                        // window with value counts
+    bufferi_order_init(&o, window_size, min_value, max_value); // initialize window with window_size as maximum size
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        bufferi_order_push(&o, input_vector[i]); // O(log range)
+        median = bufferi_order_median(&o);       // O(log range)
+        p90 = bufferi_order_quantile(&o, 0.90);  // O(log range)
+        p99 = bufferi_order_quantile(&o, 0.99);  // O(log range)
+        if (verbose)
+        {
+            bufferi_print(&o.window);
+            printf("median: %d p90: %d p99: %d\n", median, p90, p99);
+        }
+    }
+
+    bufferi_order_free(&o);
+
+    return 0;
+}
+
+// Median and percentiles with the indexable skiplist (any double samples)
+int main_median_skiplist()
+{
+    fprintf(stderr, "%s\n", __func__);
+    double median = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    bufferd_order_t o;                   // window with indexable skiplist
+    bufferd_order_init(&o, window_size); // initialize window with window_size as maximum size
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        bufferd_order_push(&o, (double)input_vector[i]); // O(log n)
+        median = bufferd_order_median(&o);               // O(log n)
+        p90 = bufferd_order_quantile(&o, 0.90);          // O(log n)
+        p99 = bufferd_order_quantile(&o, 0.99);          // O(log n)
+        if (verbose)
+        {
+            bufferd_print(&o.window);
+            printf("median: %d p90: %d p99: %d\n", (int)median, (int)p90, (int)p99);
+        }
+    }
+
+    bufferd_order_free(&o);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+int main_minmax()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int min = 0;
+    int max = 0;
+    int avg = 0;
+    bufferi_minmax_t m; // window with min/max deques
+    if (!bufferi_minmax_init(&m, window_size))
+    {
+        fprintf(stderr, "minmax: cannot allocate a window of %zu samples\n", window_size);
+        return 1;
+    }
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        bufferi_minmax_push(&m, input_vector[i], &min, &max, &avg); // amortized O(1)
+        if (verbose)
+        {
+            bufferi_print(&m.window);
+            printf("min: %d max: %d avg: %d\n", min, max, avg);
+        }
+    }
+
+    bufferi_minmax_free(&m);
+
+    return 0;
+}
+
+// Reference implementation, scanning the whole window for every sample
+int main_minmax_naive()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int min = 0;
+    int max = 0;
+    int avg = 0;
+    bufferi_t b;                        // buffer struct
+    bufferi_init_pow2(&b, window_size); // initialize buffer with window_size as maximum size (mask indexing)
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        if (b.size < b.max_size)
+        {
+            bufferi_push_back(&b, input_vector[i]); // O(1)
+        }
+        else
+        {
+            bufferi_push_and_pop(&b, input_vector[i], NULL); // O(1)
+        }
+
+        min = bufferi_get(&b, 0);
+        max = min;
+        for (size_t p = 1; p < b.size; ++p) // O(n)
+        {
+            int value = bufferi_get(&b, p);
+            if (value < min)
+            {
+                min = value;
+            }
+            if (value > max)
+            {
+                max = value;
+            }
+        }
+        avg = bufferi_mean(&b); // O(1)
+        if (verbose)
+        {
+            bufferi_print(&b);
+            printf("min: %d max: %d avg: %d\n", min, max, avg);
+        }
+    }
+
+    bufferi_free(&b);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// Same as main_iterative on the mirrored ring, the window is read as one contiguous range
+int main_mirror()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int avg = 0;
+    bufferi_mirror_t b;                   // mirrored buffer struct, keeps the running sum of the window
+    bufferi_mirror_init(&b, window_size); // initialize buffer with window_size as maximum size (rounded up to a page)
+    if (!bufferi_mirror_has_data(&b))
+    {
+        fprintf(stderr, "mirror: cannot allocate a window of %zu samples\n", window_size);
+        return 1;
+    }
+    if (b.mapped == 0)
+    {
+        fprintf(stderr, "mirror: memfd_create unavailable, heap ring with wrapped accesses\n");
+    }
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        if (b.size < b.max_size)
+        {
+            bufferi_mirror_push_back(&b, input_vector[i]); // O(1)
+        }
+        else
+        {
+            bufferi_mirror_push_and_pop(&b, input_vector[i], NULL); // O(1)
+        }
+        avg = bufferi_mirror_mean(&b); // O(1)
+        sink_put(&results, avg);
+        if (verbose)
+        {
+            const int *window[2];
+            size_t count[2];
+            // read-only, oldest first: one region when mirrored, data_ptr would rotate the heap fallback
+            bufferi_mirror_segments(&b, &window[0], &count[0], &window[1], &count[1]);
+            for (size_t s = 0; s < 2; ++s)
+            {
+                for (size_t p = 0; p < count[s]; ++p)
+                {
+                    printf("%d ", window[s][p]);
+                }
+            }
+            printf("\navg: %d\n", avg);
+        }
+    }
+
+    bufferi_mirror_free(&b);
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <circular_buffer.h>
+
+// Several window averages over the same stream in a single pass.
+// One ring holds the samples of the largest window and every window keeps its own
+// running sum, tapping the ring at its own offset for the sample it evicts.
+// Each sample costs one ring write plus one read per window, so the memory traffic
+// does not grow with the number of windows.
+typedef struct bufferi_multi_st
+{
+    bufferi_t window;    // samples of the largest window
+    size_t count;        // number of windows
+    size_t *sizes;       // size of each window
+    long long *sums;     // running sum of each window
+    divisor_t *divisors; // divisor of each window size, for the full window averages
+} bufferi_multi_t;
+
+// Quick clear, the allocations are kept
+void bufferi_multi_clear(bufferi_multi_t *m)
+{
+#ifndef NO_ASSERT
+    // check if multi window is not null
+    assert(m != NULL);
+#endif
+
+    bufferi_clear(&m->window);
+    for (size_t k = 0; k < m->count; ++k)
+    {
+        m->sums[k] = 0;
+    }
+}
+
+void bufferi_multi_init(bufferi_multi_t *m, const size_t *sizes, size_t count)
+{
+#ifndef NO_ASSERT
+    // check if multi window is not null
+    assert(m != NULL);
+
+    // check if there is at least one window
+    assert(sizes != NULL && count > 0);
+#endif
+
+    // the ring only needs the largest window
+    size_t largest = 0;
+    for (size_t k = 0; k < count; ++k)
+    {
+#ifndef NO_ASSERT
+        // check if window size is valid
+        assert(sizes[k] > 0);
+#endif
+        if (sizes[k] > largest)
+        {
+            largest = sizes[k];
+        }
+    }
+
+    bufferi_init_pow2(&m->window, largest);
+    m->count = count;
+    m->sizes = (size_t *)malloc(count * sizeof(size_t));
+    m->sums = (long long *)malloc(count * sizeof(long long));
+    m->divisors = (divisor_t *)malloc(count * sizeof(divisor_t));
+    memcpy(m->sizes, sizes, count * sizeof(size_t));
+    for (size_t k = 0; k < count; ++k)
+    {
+        divisor_init(&m->divisors[k], sizes[k]);
+    }
+
+    // initializing window and sums as empty
+    bufferi_multi_clear(m);
+}
+
+void bufferi_multi_free(bufferi_multi_t *m)
+{
+#ifndef NO_ASSERT
+    // check if multi window is not null
+    assert(m != NULL);
+#endif
+
+    bufferi_free(&m->window);
+    free(m->sizes);
+    free(m->sums);
+    free(m->divisors);
+
+    // just making sure the previous pointers are invalid
+    m->sizes = NULL;
+    m->sums = NULL;
+    m->divisors = NULL;
+    m->count = 0;
+}
+
+// Pushes value and writes the average of every window in avg_out[0..count) (can be NULL)
+void bufferi_multi_push(bufferi_multi_t *m, int value, int *avg_out)
+{
+#ifndef NO_ASSERT
+    // check if multi window is not null
+    assert(m != NULL);
+
+    // check if sums are allocated
+    assert(m->sums != NULL);
+#endif
+
+    bufferi_t *b = &m->window;
+    size_t size = b->size;
+
+    // each full window evicts the sample at its own offset (read before the ring is written)
+    for (size_t k = 0; k < m->count; ++k)
+    {
+        size_t w = m->sizes[k];
+        if (size >= w)
+        {
+            m->sums[k] -= b->data[bufferi_wrap(b, b->cur + size - w)];
+        }
+        m->sums[k] += value;
+    }
+
+    if (size < b->max_size)
+    {
+        bufferi_push_back(b, value);
+    }
+    else
+    {
+        bufferi_push_and_pop(b, value, NULL);
+    }
+
+    if (avg_out != NULL)
+    {
+        for (size_t k = 0; k < m->count; ++k)
+        {
+            // full windows divide by a multiply-shift, the divisor never changes
+            avg_out[k] = (b->size >= m->sizes[k]) ? (int)divisor_divide(&m->divisors[k], m->sums[k])
+                                                  : (int)(m->sums[k] / (long long)b->size);
+        }
+    }
+}
+
+// Average of window k in O(1)
+int bufferi_multi_mean(bufferi_multi_t *m, size_t k)
+{
+#ifndef NO_ASSERT
+    // check if multi window is not null
+    assert(m != NULL);
+
+    // check if window is valid and not empty
+    assert(k < m->count && m->window.size > 0);
+#endif
+
+    if (m->window.size >= m->sizes[k])
+    {
+        // full window, the divisor never changes
+        return (int)divisor_divide(&m->divisors[k], m->sums[k]);
+    }
+    return (int)(m->sums[k] / (long long)m->window.size);
+}
@@ -0,0 +1,54 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+int main_multi_window()
+{
+    fprintf(stderr, "%s\n", __func__);
+    const size_t sizes[] = MULTI_WINDOW_SIZES;
+    const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    int avg[sizeof(sizes) / sizeof(sizes[0])];
+    bufferi_multi_t m;                    // one ring, one running sum per window
+    bufferi_multi_init(&m, sizes, count); // initialize with the MULTI_WINDOW_SIZES windows
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        bufferi_multi_push(&m, input_vector[i], avg); // O(windows)
+        if (verbose)
+        {
+            printf("avg:");
+            for (size_t k = 0; k < count; ++k)
+            {
+                printf(" %zu=%d", sizes[k], avg[k]);
+            }
+            printf("\n");
+        }
+    }
+
+    bufferi_multi_free(&m);
+
+    return 0;
+}
@@ -0,0 +1,473 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <circular_buffer.h>
+
+// Exact sliding window order statistics (median, percentiles), shadowing a circular buffer window.
+// Quantiles use the nearest rank definition: q selects the element of rank ceil(q * size) - 1,
+// so the median of an even window is the lower middle element.
+
+// Rank selected by quantile q in a window of size n
+size_t order_rank(double q, size_t n)
+{
+    double r = ceil(q * (double)n) - 1.0;
+    if (r < 0.0)
+    {
+        return 0;
+    }
+    if (r > (double)(n - 1))
+    {
+        return n - 1;
+    }
+    return (size_t)r;
+}
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  INT32 VALUES                                          *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// Widest value range bufferi_order_t is used for (a 16MB tree), wider inputs should use bufferd_order_t
+#define ORDER_MAX_RANGE (1 << 22)
+
+// Counting structure for bounded int samples: a Fenwick tree over [min_value, max_value]
+// holds how many window samples have each value, updates and rank queries are O(log range).
+// Samples outside the range are rejected (see bufferi_order_push).
+typedef struct bufferi_order_st
+{
+    bufferi_t window; // window samples
+    int min_value;    // smallest value counted
+    size_t range;     // number of distinct values counted (max_value - min_value + 1)
+    size_t top;       // highest power of two <= range (rank search start)
+    unsigned *tree;   // Fenwick tree, 1-indexed, range + 1 positions
+} bufferi_order_t;
+
+// Quick clear, the allocations are kept
+void bufferi_order_clear(bufferi_order_t *o)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+#endif
+
+    bufferi_clear(&o->window);
+    if (o->tree != NULL)
+    {
+        memset(o->tree, 0, (o->range + 1) * sizeof(unsigned));
+    }
+}
+
+void bufferi_order_init(bufferi_order_t *o, size_t max_size, int min_value, int max_value)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+
+    // check if value range is valid
+    assert(min_value <= max_value);
+#endif
+
+    bufferi_init_pow2(&o->window, max_size);
+    o->min_value = min_value;
+    o->range = (size_t)((long long)max_value - (long long)min_value + 1);
+    o->top = circular_next_pow2(o->range + 1) >> 1;
+    o->tree = (unsigned *)malloc((o->range + 1) * sizeof(unsigned));
+
+    // initializing window and counts as empty
+    bufferi_order_clear(o);
+}
+
+void bufferi_order_free(bufferi_order_t *o)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+#endif
+
+    bufferi_free(&o->window);
+    free(o->tree);
+
+    // just making sure the previous pointer is invalid
+    o->tree = NULL;
+    o->range = 0;
+    o->top = 0;
+}
+
+// Whether value is inside the counted range
+int bufferi_order_accepts(bufferi_order_t *o, int value)
+{
+    long long v = (long long)value - o->min_value;
+    return v >= 0 && v < (long long)o->range;
+}
+
+// Adds delta to the count of value, which must be inside the counted range: internal to
+// bufferi_order_push, which only counts values that passed bufferi_order_accepts
+void bufferi_order_count(bufferi_order_t *o, int value, int delta)
+{
+#ifndef NO_ASSERT
+    // check if value is counted
+    assert(bufferi_order_accepts(o, value));
+#endif
+
+    size_t v = (size_t)((long long)value - o->min_value);
+    for (size_t i = v + 1; i <= o->range; i += i & (~i + 1))
+    {
+        o->tree[i] += (unsigned)delta;
+    }
+}
+
+// Pushes value into the window (evicting the oldest sample when full), O(log range).
+// Returns 0 and leaves the window unchanged when value is outside the counted range.
+int bufferi_order_push(bufferi_order_t *o, int value)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+
+    // check if counts are allocated
+    assert(o->tree != NULL);
+#endif
+
+    // not an assertion: an input outside the range is rejected, not a caller bug
+    if (!bufferi_order_accepts(o, value))
+    {
+        return 0;
+    }
+
+    if (o->window.size < o->window.max_size)
+    {
+        bufferi_push_back(&o->window, value);
+    }
+    else
+    {
+        int evicted;
+        bufferi_push_and_pop(&o->window, value, &evicted);
+        bufferi_order_count(o, evicted, -1);
+    }
+    bufferi_order_count(o, value, +1);
+    return 1;
+}
+
+// Window element of the given rank (0 is the minimum), O(log range)
+int bufferi_order_rank(bufferi_order_t *o, size_t rank)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+
+    // check if rank is valid
+    assert(rank < o->window.size);
+#endif
+
+    // descend the implicit tree looking for the first value whose prefix count is > rank
+    size_t pos = 0;
+    size_t remaining = rank + 1;
+    for (size_t step = o->top; step > 0; step >>= 1)
+    {
+        if (pos + step <= o->range && o->tree[pos + step] < remaining)
+        {
+            pos += step;
+            remaining -= o->tree[pos];
+        }
+    }
+    return o->min_value + (int)pos;
+}
+
+// Window quantile, q in [0, 1] (0.9 for p90), O(log range)
+int bufferi_order_quantile(bufferi_order_t *o, double q)
+{
+    return bufferi_order_rank(o, order_rank(q, o->window.size));
+}
+
+int bufferi_order_median(bufferi_order_t *o)
+{
+    return bufferi_order_quantile(o, 0.5);
+}
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  DOUBLE VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+#define ORDER_NIL ((size_t)-1)
+
+// Indexable skiplist over the window samples: every link also stores how many ranks it skips,
+// so insertion, removal and rank queries are O(log n) expected.
+// The nodes live in a pool of max_size + 1 entries (entry 0 is the head), nothing is allocated per sample.
+typedef struct bufferd_order_st
+{
+    bufferd_t window;        // window samples
+    size_t levels;           // number of skiplist levels
+    double *value;           // node values
+    size_t *next;            // node links, levels per node
+    size_t *width;           // ranks skipped by each link, levels per node
+    size_t *height;          // node number of levels
+    size_t *unused;          // stack of unused nodes
+    size_t unused_size;      // number of unused nodes
+    size_t *chain;           // search path scratch, levels entries
+    size_t *steps;           // search path ranks scratch, levels entries
+    unsigned long long seed; // level generator state
+} bufferd_order_t;
+
+// Quick clear, the allocations are kept
+void bufferd_order_clear(bufferd_order_t *o)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+#endif
+
+    bufferd_clear(&o->window);
+
+    // empty list: the head links straight to the end
+    for (size_t l = 0; l < o->levels; ++l)
+    {
+        o->next[l] = ORDER_NIL;
+        o->width[l] = 1;
+    }
+    o->height[0] = o->levels;
+
+    // every other node is unused
+    o->unused_size = 0;
+    for (size_t n = o->window.max_size; n > 0; --n)
+    {
+        o->unused[o->unused_size++] = n;
+    }
+}
+
+void bufferd_order_init(bufferd_order_t *o, size_t max_size)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+#endif
+
+    bufferd_init_pow2(&o->window, max_size);
+
+    // log2(max_size) + 1 levels
+    o->levels = 1;
+    while (((size_t)1 << o->levels) <= max_size)
+    {
+        o->levels++;
+    }
+
+    size_t nodes = max_size + 1;
+    o->value = (double *)malloc(nodes * sizeof(double));
+    o->next = (size_t *)malloc(nodes * o->levels * sizeof(size_t));
+    o->width = (size_t *)malloc(nodes * o->levels * sizeof(size_t));
+    o->height = (size_t *)malloc(nodes * sizeof(size_t));
+    o->unused = (size_t *)malloc(nodes * sizeof(size_t));
+    o->chain = (size_t *)malloc(o->levels * sizeof(size_t));
+    o->steps = (size_t *)malloc(o->levels * sizeof(size_t));
+    o->seed = 0x9E3779B97F4A7C15ULL;
+
+    // initializing window and list as empty
+    bufferd_order_clear(o);
+}
+
+void bufferd_order_free(bufferd_order_t *o)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+#endif
+
+    bufferd_free(&o->window);
+    free(o->value);
+    free(o->next);
+    free(o->width);
+    free(o->height);
+    free(o->unused);
+    free(o->chain);
+    free(o->steps);
+
+    // just making sure the previous pointers are invalid
+    o->value = NULL;
+    o->next = NULL;
+    o->width = NULL;
+    o->height = NULL;
+    o->unused = NULL;
+    o->chain = NULL;
+    o->steps = NULL;
+    o->levels = 0;
+    o->unused_size = 0;
+}
+
+// Random node height, P(height > h) = 2^-h
+size_t bufferd_order_height(bufferd_order_t *o)
+{
+    // xorshift64
+    o->seed ^= o->seed << 13;
+    o->seed ^= o->seed >> 7;
+    o->seed ^= o->seed << 17;
+
+    size_t h = 1;
+    unsigned long long bits = o->seed;
+    while (h < o->levels && (bits & 1))
+    {
+        h++;
+        bits >>= 1;
+    }
+    return h;
+}
+
+void bufferd_order_insert(bufferd_order_t *o, double value)
+{
+    size_t L = o->levels;
+
+    // search path: last node before value at each level and its rank
+    size_t node = 0;
+    size_t rank = 0;
+    for (size_t l = L; l-- > 0;)
+    {
+        while (o->next[node * L + l] != ORDER_NIL && o->value[o->next[node * L + l]] <= value)
+        {
+            rank += o->width[node * L + l];
+            node = o->next[node * L + l];
+        }
+        o->chain[l] = node;
+        o->steps[l] = rank;
+    }
+
+    size_t n = o->unused[--o->unused_size];
+    size_t h = bufferd_order_height(o);
+    o->value[n] = value;
+    o->height[n] = h;
+
+    // link the new node at rank + 1
+    for (size_t l = 0; l < h; ++l)
+    {
+        size_t prev = o->chain[l];
+        o->next[n * L + l] = o->next[prev * L + l];
+        o->next[prev * L + l] = n;
+        o->width[n * L + l] = o->width[prev * L + l] - (rank - o->steps[l]);
+        o->width[prev * L + l] = rank + 1 - o->steps[l];
+    }
+
+    // the links above it now skip one more rank
+    for (size_t l = h; l < L; ++l)
+    {
+        o->width[o->chain[l] * L + l]++;
+    }
+}
+
+void bufferd_order_remove(bufferd_order_t *o, double value)
+{
+    size_t L = o->levels;
+
+    // search path: last node before the first occurrence of value at each level
+    size_t node = 0;
+    for (size_t l = L; l-- > 0;)
+    {
+        while (o->next[node * L + l] != ORDER_NIL && o->value[o->next[node * L + l]] < value)
+        {
+            node = o->next[node * L + l];
+        }
+        o->chain[l] = node;
+    }
+
+    size_t n = o->next[o->chain[0] * L];
+#ifndef NO_ASSERT
+    // check if value is in the list
+    assert(n != ORDER_NIL && o->value[n] == value);
+#endif
+
+    // unlink the node, the links above it now skip one rank less
+    for (size_t l = 0; l < L; ++l)
+    {
+        size_t prev = o->chain[l];
+        if (l < o->height[n])
+        {
+            o->width[prev * L + l] += o->width[n * L + l] - 1;
+            o->next[prev * L + l] = o->next[n * L + l];
+        }
+        else
+        {
+            o->width[prev * L + l]--;
+        }
+    }
+
+    o->unused[o->unused_size++] = n;
+}
+
+// Pushes value into the window (evicting the oldest sample when full), O(log n) expected
+void bufferd_order_push(bufferd_order_t *o, double value)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+
+    // check if list is allocated
+    assert(o->value != NULL);
+#endif
+
+    if (o->window.size < o->window.max_size)
+    {
+        bufferd_push_back(&o->window, value);
+    }
+    else
+    {
+        double evicted;
+        bufferd_push_and_pop(&o->window, value, &evicted);
+        bufferd_order_remove(o, evicted);
+    }
+    bufferd_order_insert(o, value);
+}
+
+// Window element of the given rank (0 is the minimum), O(log n) expected
+double bufferd_order_rank(bufferd_order_t *o, size_t rank)
+{
+#ifndef NO_ASSERT
+    // check if order is not null
+    assert(o != NULL);
+
+    // check if rank is valid
+    assert(rank < o->window.size);
+#endif
+
+    size_t L = o->levels;
+    size_t node = 0;
+    size_t remaining = rank + 1;
+    for (size_t l = L; l-- > 0;)
+    {
+        while (o->next[node * L + l] != ORDER_NIL && o->width[node * L + l] <= remaining)
+        {
+            remaining -= o->width[node * L + l];
+            node = o->next[node * L + l];
+        }
+    }
+    return o->value[node];
+}
+
+// Window quantile, q in [0, 1] (0.9 for p90), O(log n) expected
+double bufferd_order_quantile(bufferd_order_t *o, double q)
+{
+    return bufferd_order_rank(o, order_rank(q, o->window.size));
+}
+
+double bufferd_order_median(bufferd_order_t *o)
+{
+    return bufferd_order_quantile(o, 0.5);
+}
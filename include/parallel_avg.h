@@ -0,0 +1,148 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <pthread.h>
+#include <unistd.h>
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// Averages of every sample, allocated once by parallel_setup outside the timed runs
+int *parallel_avg = NULL;
+
+void parallel_setup(void)
+{
+    parallel_avg = (int *)malloc(input_vector_size * sizeof(int));
+}
+
+void parallel_teardown(void)
+{
+    free(parallel_avg);
+    parallel_avg = NULL;
+}
+
+typedef struct parallel_chunk_st
+{
+    size_t begin; // first sample of the chunk
+    size_t end;   // one past the last sample of the chunk
+    int *avg;     // averages of the whole input (the chunk writes [begin, end))
+    int threaded; // runs on its own thread (to join), 0 when it ran on the calling thread
+} parallel_chunk_t;
+
+// Averages one chunk; the buffer is first primed with the window_size - 1 samples before
+// the chunk (the halo), so every average matches the serial one.
+void *parallel_worker(void *arg)
+{
+    parallel_chunk_t *chunk = (parallel_chunk_t *)arg;
+    size_t halo = (chunk->begin < window_size - 1) ? chunk->begin : window_size - 1;
+
+    bufferi_t b;                        // buffer struct
+    bufferi_init_pow2(&b, window_size); // initialize buffer with window_size as maximum size (mask indexing)
+
+    // prime the window with the halo, no averages needed
+    bufferi_push_many(&b, input_vector + chunk->begin - halo, halo, NULL);
+
+    // averages of the chunk itself
+    bufferi_push_many(&b, input_vector + chunk->begin, chunk->end - chunk->begin, chunk->avg + chunk->begin);
+
+    bufferi_free(&b);
+    return NULL;
+}
+
+int main_parallel()
+{
+    fprintf(stderr, "%s\n", __func__);
+    size_t threads = parallel_threads;
+    if (threads == 0)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cores > 0) ? (size_t)cores : 1;
+    }
+    fprintf(stderr, "threads: %zu\n", threads);
+
+    int *avg = parallel_avg; // averages of every sample, from parallel_setup
+    if (avg == NULL)
+    {
+        fprintf(stderr, "parallel: cannot allocate %zu averages\n", input_vector_size);
+        return 1;
+    }
+    pthread_t *tid = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    parallel_chunk_t *chunks = (parallel_chunk_t *)malloc(threads * sizeof(parallel_chunk_t));
+    if (tid == NULL || chunks == NULL)
+    {
+        fprintf(stderr, "parallel: cannot allocate %zu threads\n", threads);
+        free(chunks);
+        free(tid);
+        return 1;
+    }
+
+    // contiguous chunks of (almost) the same size
+    for (size_t t = 0; t < threads; ++t)
+    {
+        chunks[t].begin = input_vector_size * t / threads;
+        chunks[t].end = input_vector_size * (t + 1) / threads;
+        chunks[t].avg = avg;
+        chunks[t].threaded = (pthread_create(&tid[t], NULL, parallel_worker, &chunks[t]) == 0);
+        if (!chunks[t].threaded)
+        {
+            // no thread for this chunk (e.g. EAGAIN), the serial path gives the same averages
+            parallel_worker(&chunks[t]);
+        }
+    }
+    for (size_t t = 0; t < threads; ++t)
+    {
+        if (chunks[t].threaded)
+        {
+            pthread_join(tid[t], NULL);
+        }
+    }
+    sink_write(&results, avg, input_vector_size);
+
+    if (verbose)
+    {
+        // compare with the serial per-sample path (main_iterative), independent of push_many
+        bufferi_t b;
+        bufferi_init_pow2(&b, window_size);
+        int equal = 1;
+        for (size_t i = 0; i < input_vector_size; ++i)
+        {
+            if (b.size < b.max_size)
+            {
+                bufferi_push_back(&b, input_vector[i]);
+            }
+            else
+            {
+                bufferi_push_and_pop(&b, input_vector[i], NULL);
+            }
+            equal = equal && (bufferi_mean(&b) == avg[i]);
+            printf("avg: %d\n", avg[i]);
+        }
+        printf("parallel == serial: %s\n", equal ? "yes" : "no");
+        bufferi_free(&b);
+    }
+
+    free(chunks);
+    free(tid);
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// Hardware performance counters through Linux perf_event_open.
+// Every event is opened on its own (user space only, inherited by the threads a method creates),
+// so a missing or forbidden event (e.g. perf_event_paranoid, containers, VMs) only disables itself.
+// Multiplexed counts are scaled by time_enabled / time_running.
+
+typedef enum perf_event_en
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENTS
+} perf_event_t;
+
+const char *perf_event_names[PERF_EVENTS] = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+
+typedef struct perf_counters_st
+{
+    int fd[PERF_EVENTS];       // event file descriptors, -1 when not available
+    double value[PERF_EVENTS]; // counts accumulated since the last reset
+    int available;             // number of events opened
+} perf_counters_t;
+
+int perf_counters_event(perf_event_t e)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (e)
+    {
+    case PERF_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_L1D_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PERF_LLC_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case PERF_BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    default:
+        return -1;
+    }
+
+    // this process (and its future threads), any cpu, no group
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Opens every event it can, returns how many are available
+int perf_counters_open(perf_counters_t *p)
+{
+    p->available = 0;
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        p->fd[e] = perf_counters_event((perf_event_t)e);
+        p->value[e] = 0.0;
+        if (p->fd[e] >= 0)
+        {
+            p->available++;
+        }
+    }
+    return p->available;
+}
+
+void perf_counters_close(perf_counters_t *p)
+{
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        if (p->fd[e] >= 0)
+        {
+            close(p->fd[e]);
+        }
+        p->fd[e] = -1;
+    }
+    p->available = 0;
+}
+
+// Clears the accumulated counts
+void perf_counters_reset(perf_counters_t *p)
+{
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        p->value[e] = 0.0;
+    }
+}
+
+void perf_counters_start(perf_counters_t *p)
+{
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        if (p->fd[e] >= 0)
+        {
+            ioctl(p->fd[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(p->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+// Stops the counters and adds the counts of this run to value
+void perf_counters_stop(perf_counters_t *p)
+{
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        if (p->fd[e] >= 0)
+        {
+            ioctl(p->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (int e = 0; e < PERF_EVENTS; ++e)
+    {
+        // value, time enabled, time running
+        unsigned long long data[3];
+        if (p->fd[e] >= 0 && read(p->fd[e], data, sizeof(data)) == (ssize_t)sizeof(data) && data[2] > 0)
+        {
+            p->value[e] += (double)data[0] * ((double)data[1] / (double)data[2]);
+        }
+    }
+}
+
+// Whether event e was counted
+int perf_counters_has(perf_counters_t *p, perf_event_t e)
+{
+    return p->fd[e] >= 0;
+}
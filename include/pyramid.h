@@ -0,0 +1,192 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <circular_buffer.h>
+
+// Multi-resolution downsampling pyramid (e.g. second, minute and hour averages of the same stream).
+// Level 0 keeps the raw samples, every factors[k] samples entering level k - 1 are averaged into
+// one sample of level k. Each level has its own ring of windows[k] samples with a running sum,
+// so the memory is O(levels x window) and the average of any level is O(1).
+// The block sums are accumulated as the samples go through, a level is only touched
+// when the level below completes a block (amortized O(1) per sample for factors >= 2).
+typedef struct bufferd_pyramid_st
+{
+    bufferd_t *levels; // ring of each level, level 0 holds the raw samples
+    size_t *factors;   // level k - 1 samples per level k sample (factors[0] is 1)
+    double *pending;   // sum of the incomplete block of each level
+    size_t *filled;    // samples in the incomplete block of each level
+    size_t count;      // number of levels
+} bufferd_pyramid_t;
+
+// Quick clear, the allocations are kept
+void bufferd_pyramid_clear(bufferd_pyramid_t *p)
+{
+#ifndef NO_ASSERT
+    // check if pyramid is not null
+    assert(p != NULL);
+#endif
+
+    for (size_t k = 0; k < p->count; ++k)
+    {
+        bufferd_clear(&p->levels[k]);
+        p->pending[k] = 0.0;
+        p->filled[k] = 0;
+    }
+}
+
+// windows[k] is the ring size of level k, factors[k] the decimation from level k - 1 to level k
+void bufferd_pyramid_init(bufferd_pyramid_t *p, const size_t *windows, const size_t *factors, size_t count)
+{
+#ifndef NO_ASSERT
+    // check if pyramid is not null
+    assert(p != NULL);
+
+    // check if there is at least one level
+    assert(windows != NULL && factors != NULL && count > 0);
+
+    // check if the first level holds the raw samples
+    assert(factors[0] == 1);
+#endif
+
+    p->count = count;
+    p->levels = (bufferd_t *)malloc(count * sizeof(bufferd_t));
+    p->factors = (size_t *)malloc(count * sizeof(size_t));
+    p->pending = (double *)malloc(count * sizeof(double));
+    p->filled = (size_t *)malloc(count * sizeof(size_t));
+    memcpy(p->factors, factors, count * sizeof(size_t));
+    for (size_t k = 0; k < count; ++k)
+    {
+#ifndef NO_ASSERT
+        // check if window size and factor are valid
+        assert(windows[k] > 0 && factors[k] > 0);
+#endif
+        bufferd_init_pow2(&p->levels[k], windows[k]);
+    }
+
+    // initializing levels and blocks as empty
+    bufferd_pyramid_clear(p);
+}
+
+void bufferd_pyramid_free(bufferd_pyramid_t *p)
+{
+#ifndef NO_ASSERT
+    // check if pyramid is not null
+    assert(p != NULL);
+#endif
+
+    for (size_t k = 0; k < p->count; ++k)
+    {
+        bufferd_free(&p->levels[k]);
+    }
+    free(p->levels);
+    free(p->factors);
+    free(p->pending);
+    free(p->filled);
+
+    // just making sure the previous pointers are invalid
+    p->levels = NULL;
+    p->factors = NULL;
+    p->pending = NULL;
+    p->filled = NULL;
+    p->count = 0;
+}
+
+// Raw samples averaged into one sample of level k
+size_t bufferd_pyramid_resolution(bufferd_pyramid_t *p, size_t k)
+{
+#ifndef NO_ASSERT
+    // check if pyramid is not null and level is valid
+    assert(p != NULL && k < p->count);
+#endif
+
+    size_t resolution = 1;
+    for (size_t l = 1; l <= k; ++l)
+    {
+        resolution *= p->factors[l];
+    }
+    return resolution;
+}
+
+// Pushes value into level 0 and cascades the completed blocks into the coarser levels.
+// Writes the average of every level in avg_out[0..count) (can be NULL), 0 for a level without samples yet.
+void bufferd_pyramid_push(bufferd_pyramid_t *p, double value, double *avg_out)
+{
+#ifndef NO_ASSERT
+    // check if pyramid is not null
+    assert(p != NULL);
+
+    // check if levels are allocated
+    assert(p->levels != NULL);
+#endif
+
+    for (size_t k = 0; k < p->count; ++k)
+    {
+        bufferd_t *b = &p->levels[k];
+        if (b->size < b->max_size)
+        {
+            bufferd_push_back(b, value); // O(1)
+        }
+        else
+        {
+            bufferd_push_and_pop(b, value, NULL); // O(1)
+        }
+
+        // the sample also goes into the incomplete block of the next level
+        if (k + 1 == p->count)
+        {
+            break;
+        }
+        p->pending[k + 1] += value;
+        if (++p->filled[k + 1] < p->factors[k + 1])
+        {
+            break;
+        }
+
+        // block complete: its average is the next level sample
+        value = p->pending[k + 1] / (double)p->factors[k + 1];
+        p->pending[k + 1] = 0.0;
+        p->filled[k + 1] = 0;
+    }
+
+    if (avg_out != NULL)
+    {
+        for (size_t k = 0; k < p->count; ++k)
+        {
+            avg_out[k] = (p->levels[k].size > 0) ? bufferd_mean(&p->levels[k]) : 0.0;
+        }
+    }
+}
+
+// Average of the window of level k in O(1)
+double bufferd_pyramid_mean(bufferd_pyramid_t *p, size_t k)
+{
+#ifndef NO_ASSERT
+    // check if pyramid is not null
+    assert(p != NULL);
+
+    // check if level is valid and not empty
+    assert(k < p->count && p->levels[k].size > 0);
+#endif
+
+    return bufferd_mean(&p->levels[k]);
+}
@@ -0,0 +1,55 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+int main_pyramid()
+{
+    fprintf(stderr, "%s\n", __func__);
+    const size_t windows[] = PYRAMID_WINDOWS;
+    const size_t factors[] = PYRAMID_FACTORS;
+    const size_t count = sizeof(windows) / sizeof(windows[0]);
+    double avg[sizeof(windows) / sizeof(windows[0])];
+    bufferd_pyramid_t p;                               // one ring per level
+    bufferd_pyramid_init(&p, windows, factors, count); // initialize with the PYRAMID_WINDOWS levels
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        bufferd_pyramid_push(&p, (double)input_vector[i], avg); // amortized O(1), O(levels) averages
+        if (verbose)
+        {
+            printf("avg:");
+            for (size_t k = 0; k < count; ++k)
+            {
+                printf(" %zu=%f", bufferd_pyramid_resolution(&p, k), avg[k]);
+            }
+            printf("\n");
+        }
+    }
+
+    bufferd_pyramid_free(&p);
+
+    return 0;
+}
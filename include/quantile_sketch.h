@@ -0,0 +1,231 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <math.h>
+#include <circular_buffer.h>
+#include <order_statistics.h>
+
+// Approximate quantiles with bounded memory (logarithmic buckets, DDSketch style).
+// A value x > 0 is counted in bucket ceil(log_gamma(x)), gamma = (1 + alpha) / (1 - alpha),
+// and read back as the bucket center, so any quantile is within a relative error alpha.
+// Counts can be decremented, so the sketch follows a sliding window from the push/evict
+// events of a circular buffer (e.g. the pop_value of bufferd_push_and_pop).
+// The memory is fixed by [min_value, max_value]: magnitudes below min_value count as zero,
+// magnitudes above max_value are counted in the last bucket and lose the error bound,
+// sketchd_clamped reports how many of them are in the sketch.
+// The buckets are kept in a Fenwick tree, so add/remove/quantile are O(log buckets).
+typedef struct sketchd_st
+{
+    double alpha;         // relative error bound
+    double gamma;         // bucket growth factor
+    double log_gamma_inv; // 1 / log(gamma)
+    double min_value;     // smallest magnitude with its own bucket
+    int offset;           // bucket key of min_value
+    size_t buckets;       // buckets per sign
+    size_t range;         // tree positions: negative buckets, zero, positive buckets
+    size_t top;           // highest power of two <= range (rank search start)
+    unsigned *tree;       // Fenwick tree of bucket counts, 1-indexed, range + 1 positions
+    size_t count;         // number of values in the sketch
+    size_t clamped;       // values in the sketch with a magnitude above max_value
+} sketchd_t;
+
+// Quick clear, the allocation is kept
+void sketchd_clear(sketchd_t *s)
+{
+#ifndef NO_ASSERT
+    // check if sketch is not null
+    assert(s != NULL);
+#endif
+
+    if (s->tree != NULL)
+    {
+        memset(s->tree, 0, (s->range + 1) * sizeof(unsigned));
+    }
+    s->count = 0;
+    s->clamped = 0;
+}
+
+void sketchd_init(sketchd_t *s, double alpha, double min_value, double max_value)
+{
+#ifndef NO_ASSERT
+    // check if sketch is not null
+    assert(s != NULL);
+
+    // check if parameters are valid
+    assert(alpha > 0.0 && alpha < 1.0);
+    assert(min_value > 0.0 && min_value <= max_value);
+#endif
+
+    s->alpha = alpha;
+    s->gamma = (1.0 + alpha) / (1.0 - alpha);
+    s->log_gamma_inv = 1.0 / log(s->gamma);
+    s->min_value = min_value;
+    s->offset = (int)ceil(log(min_value) * s->log_gamma_inv);
+    s->buckets = (size_t)((int)ceil(log(max_value) * s->log_gamma_inv) - s->offset + 1);
+    s->range = 2 * s->buckets + 1;
+    s->top = circular_next_pow2(s->range + 1) >> 1;
+    s->tree = (unsigned *)malloc((s->range + 1) * sizeof(unsigned));
+
+    // initializing counts as empty
+    sketchd_clear(s);
+}
+
+void sketchd_free(sketchd_t *s)
+{
+#ifndef NO_ASSERT
+    // check if sketch is not null
+    assert(s != NULL);
+#endif
+
+    free(s->tree);
+
+    // just making sure the previous pointer is invalid
+    s->tree = NULL;
+    s->range = 0;
+    s->top = 0;
+    s->buckets = 0;
+    s->count = 0;
+    s->clamped = 0;
+}
+
+// Tree position of value: negative buckets (largest magnitude first), zero, positive buckets.
+// *overflow is set when the magnitude is above the last bucket (its quantiles lose the error bound),
+// the value is then counted in the last bucket.
+size_t sketchd_position(sketchd_t *s, double value, int *overflow)
+{
+    double magnitude = fabs(value);
+    *overflow = 0;
+    if (magnitude < s->min_value)
+    {
+        return s->buckets;
+    }
+
+    // the log is the expensive part of an update, computed once
+    long long key = (long long)ceil(log(magnitude) * s->log_gamma_inv) - s->offset;
+    if (key < 0)
+    {
+        key = 0;
+    }
+    if (key >= (long long)s->buckets)
+    {
+        key = (long long)s->buckets - 1;
+        *overflow = 1;
+    }
+
+    if (value < 0.0)
+    {
+        return s->buckets - 1 - (size_t)key;
+    }
+    return s->buckets + 1 + (size_t)key;
+}
+
+// Representative value of a tree position (bucket center, within alpha of every value in it)
+double sketchd_value(sketchd_t *s, size_t pos)
+{
+    if (pos == s->buckets)
+    {
+        return 0.0;
+    }
+
+    double sign = (pos < s->buckets) ? -1.0 : 1.0;
+    long long key = (pos < s->buckets) ? (long long)(s->buckets - 1 - pos) : (long long)(pos - s->buckets - 1);
+    return sign * 2.0 * pow(s->gamma, (double)(key + s->offset)) / (s->gamma + 1.0);
+}
+
+void sketchd_count(sketchd_t *s, double value, int delta)
+{
+    int overflow;
+    size_t pos = sketchd_position(s, value, &overflow);
+    if (overflow)
+    {
+        s->clamped = (delta > 0) ? s->clamped + 1 : s->clamped - 1;
+    }
+    for (size_t i = pos + 1; i <= s->range; i += i & (~i + 1))
+    {
+        s->tree[i] += (unsigned)delta;
+    }
+}
+
+// Adds a value (window push), O(log buckets)
+void sketchd_add(sketchd_t *s, double value)
+{
+#ifndef NO_ASSERT
+    // check if sketch is not null
+    assert(s != NULL);
+#endif
+
+    sketchd_count(s, value, +1);
+    s->count++;
+}
+
+// Removes a previously added value (window eviction), O(log buckets)
+void sketchd_remove(sketchd_t *s, double value)
+{
+#ifndef NO_ASSERT
+    // check if sketch is not null
+    assert(s != NULL);
+
+    // check if sketch is not empty
+    assert(s->count > 0);
+#endif
+
+    sketchd_count(s, value, -1);
+    s->count--;
+}
+
+// Approximate quantile, q in [0, 1], same rank definition as order_statistics.h, O(log buckets)
+double sketchd_quantile(sketchd_t *s, double q)
+{
+#ifndef NO_ASSERT
+    // check if sketch is not null
+    assert(s != NULL);
+
+    // check if sketch is not empty
+    assert(s->count > 0);
+#endif
+
+    // descend the implicit tree looking for the first position whose prefix count is > rank
+    size_t pos = 0;
+    size_t remaining = order_rank(q, s->count) + 1;
+    for (size_t step = s->top; step > 0; step >>= 1)
+    {
+        if (pos + step <= s->range && s->tree[pos + step] < remaining)
+        {
+            pos += step;
+            remaining -= s->tree[pos];
+        }
+    }
+    return sketchd_value(s, pos);
+}
+
+// Number of values in the sketch counted in the last bucket although they are above max_value
+size_t sketchd_clamped(sketchd_t *s)
+{
+    return s->clamped;
+}
+
+// Fixed memory used by the sketch, in bytes
+size_t sketchd_memory(sketchd_t *s)
+{
+    return sizeof(sketchd_t) + (s->range + 1) * sizeof(unsigned);
+}
@@ -0,0 +1,312 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <defines.h>
+#include <alloc_vec.h>
+
+// Output stage for the computed averages: a preallocated array, or a file written through
+// a SINK_BUFFER bytes aligned buffer, as an int32 input file (see map_input_vector, so it can be
+// read back with -i) or as text lines formatted in batches (no printf per average).
+// The file can be opened with O_DIRECT (when the platform has it), the full buffers then skip the
+// page cache and only the last partial buffer and the header go through it.
+// Each run of a method with output (see bench_method_t) starts the output again,
+// so the sink holds the averages of the last such run.
+
+// Alignment of the write buffer and of the O_DIRECT writes
+#define SINK_ALIGNMENT 4096
+
+typedef enum sink_mode_en
+{
+    SINK_NONE,   // averages are discarded
+    SINK_ARRAY,  // averages are stored in a preallocated array
+    SINK_BINARY, // averages are written to a file as int32 (with an input file header)
+    SINK_TEXT    // averages are written to a file, one per line
+} sink_mode_t;
+
+typedef struct result_sink_st
+{
+    sink_mode_t mode; // output kind
+    int *array;       // preallocated averages (SINK_ARRAY)
+    size_t capacity;  // array size, extra averages are dropped
+    size_t count;     // averages of the current run
+    int fd;           // output file, -1 without file
+    int direct;       // the file is open with O_DIRECT
+    char *buffer;     // aligned write buffer
+    size_t used;      // bytes waiting in the buffer
+    size_t written;   // bytes written to the file in the current run
+    int error;        // errno of the first failed write, 0 otherwise
+} result_sink_t;
+
+// Sink of the averages of the methods (see sink_open)
+result_sink_t results = {SINK_NONE, NULL, 0, 0, -1, 0, NULL, 0, 0, 0};
+
+// Keeps up to capacity averages in memory
+int sink_open_array(result_sink_t *s, size_t capacity)
+{
+    s->array = (int *)malloc(capacity * sizeof(int));
+    if (s->array == NULL)
+    {
+        return 0;
+    }
+    s->mode = SINK_ARRAY;
+    s->capacity = capacity;
+    s->count = 0;
+    return 1;
+}
+
+// Writes the averages to path, in binary or text mode, with O_DIRECT when direct is set
+// (falls back to the page cache when the file system refuses it)
+int sink_open_file(result_sink_t *s, const char *path, sink_mode_t mode, int direct)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    s->direct = 0;
+#ifdef O_DIRECT
+    if (direct)
+    {
+        s->fd = open(path, flags | O_DIRECT, 0644);
+        s->direct = (s->fd >= 0);
+        if (s->fd < 0 && errno == EINVAL)
+        {
+            fprintf(stderr, "%s: O_DIRECT is not supported here, using the page cache\n", path);
+        }
+    }
+#else
+    if (direct)
+    {
+        fprintf(stderr, "%s: O_DIRECT is not available, using the page cache\n", path);
+    }
+#endif
+    if (!s->direct)
+    {
+        s->fd = open(path, flags, 0644);
+    }
+    if (s->fd < 0)
+    {
+        perror(path);
+        return 0;
+    }
+
+    s->buffer = (char *)aligned_alloc(SINK_ALIGNMENT, SINK_BUFFER);
+    if (s->buffer == NULL)
+    {
+        close(s->fd);
+        s->fd = -1;
+        return 0;
+    }
+    s->mode = mode;
+    s->used = 0;
+    s->written = 0;
+    s->count = 0;
+    s->error = 0;
+    return 1;
+}
+
+// Writes the buffer to the file, keeps the bytes after the last aligned block when partial is 0
+// (O_DIRECT writes whole blocks only)
+void sink_drain(result_sink_t *s, int partial)
+{
+    size_t bytes = (s->direct && !partial) ? s->used / SINK_ALIGNMENT * SINK_ALIGNMENT : s->used;
+    size_t done = 0;
+    while (done < bytes)
+    {
+        ssize_t n = write(s->fd, s->buffer + done, bytes - done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            if (s->error == 0)
+            {
+                s->error = (n < 0) ? errno : EIO;
+            }
+            break;
+        }
+        done += (size_t)n;
+    }
+    s->written += done;
+
+    // the kept tail moves to the beginning of the buffer
+    memmove(s->buffer, s->buffer + bytes, s->used - bytes);
+    s->used -= bytes;
+}
+
+// Starts the output of a run
+void sink_begin(result_sink_t *s)
+{
+    s->count = 0;
+    if (s->fd < 0)
+    {
+        return;
+    }
+
+    lseek(s->fd, 0, SEEK_SET);
+    if (ftruncate(s->fd, 0) != 0 && s->error == 0)
+    {
+        s->error = errno;
+    }
+    s->used = 0;
+    s->written = 0;
+    if (s->mode == SINK_BINARY)
+    {
+        // the count is written by sink_end
+        input_file_header_t header = {{'A', 'V', 'G', 'S'}, INPUT_INT32, 0};
+        memcpy(s->buffer, &header, sizeof(header));
+        s->used = sizeof(header);
+    }
+}
+
+// Decimal text of value followed by a new line at dst, returns the length
+size_t sink_format(char *dst, int value)
+{
+    char digits[12];
+    size_t n = 0;
+    unsigned int u = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+    do
+    {
+        digits[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+
+    size_t len = 0;
+    if (value < 0)
+    {
+        dst[len++] = '-';
+    }
+    while (n > 0)
+    {
+        dst[len++] = digits[--n];
+    }
+    dst[len++] = '\n';
+    return len;
+}
+
+// Outputs n averages
+void sink_write(result_sink_t *s, const int *avg, size_t n)
+{
+    switch (s->mode)
+    {
+    case SINK_NONE:
+        break;
+    case SINK_ARRAY:
+    {
+        size_t room = s->capacity - s->count;
+        size_t copy = (n < room) ? n : room;
+        memcpy(s->array + s->count, avg, copy * sizeof(int));
+        s->count += copy;
+        break;
+    }
+    case SINK_BINARY:
+        while (n > 0)
+        {
+            size_t room = (SINK_BUFFER - s->used) / sizeof(int);
+            size_t copy = (n < room) ? n : room;
+            memcpy(s->buffer + s->used, avg, copy * sizeof(int));
+            s->used += copy * sizeof(int);
+            s->count += copy;
+            avg += copy;
+            n -= copy;
+            if (s->used + sizeof(int) > SINK_BUFFER)
+            {
+                sink_drain(s, 0);
+            }
+        }
+        break;
+    case SINK_TEXT:
+        for (size_t i = 0; i < n; ++i)
+        {
+            // an int is at most 12 characters with its sign and new line
+            if (s->used + 12 > SINK_BUFFER)
+            {
+                sink_drain(s, 0);
+            }
+            s->used += sink_format(s->buffer + s->used, avg[i]);
+        }
+        s->count += n;
+        break;
+    }
+}
+
+// Outputs one average
+void sink_put(result_sink_t *s, int avg)
+{
+    if (s->mode != SINK_NONE)
+    {
+        sink_write(s, &avg, 1);
+    }
+}
+
+// Ends the output of a run: writes what is left and the count of the binary header
+void sink_end(result_sink_t *s)
+{
+    if (s->fd < 0)
+    {
+        return;
+    }
+
+    sink_drain(s, 0);
+#ifdef O_DIRECT
+    if (s->direct)
+    {
+        // the tail and the header are not whole aligned blocks
+        fcntl(s->fd, F_SETFL, fcntl(s->fd, F_GETFL) & ~O_DIRECT);
+    }
+#endif
+    sink_drain(s, 1);
+    if (s->mode == SINK_BINARY)
+    {
+        uint64_t count = s->count;
+        if (pwrite(s->fd, &count, sizeof(count), offsetof(input_file_header_t, count)) != (ssize_t)sizeof(count) &&
+            s->error == 0)
+        {
+            s->error = errno;
+        }
+    }
+#ifdef O_DIRECT
+    if (s->direct)
+    {
+        fcntl(s->fd, F_SETFL, fcntl(s->fd, F_GETFL) | O_DIRECT);
+    }
+#endif
+}
+
+void sink_close(result_sink_t *s)
+{
+    if (s->fd >= 0)
+    {
+        close(s->fd);
+    }
+    free(s->array);
+    free(s->buffer);
+    s->array = NULL;
+    s->buffer = NULL;
+    s->fd = -1;
+    s->mode = SINK_NONE;
+}
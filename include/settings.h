@@ -0,0 +1,41 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <defines.h>
+
+// Runtime settings, the defaults come from defines.h
+// and avg_test overrides them from the command line (see bench.h)
+
+#ifdef BENCHMARK
+size_t input_size = BENCHMARK_SIZE; // number of input samples
+int verbose = 0;                    // print every window and average
+#else
+size_t input_size = BSZM * 4; // number of input samples
+int verbose = 1;              // print every window and average
+#endif
+
+size_t window_size = WINDOW_SIZE;           // averaging window size
+size_t parallel_threads = PARALLEL_THREADS; // threads used by main_parallel, 0 uses every online core
+const char *input_path = NULL;              // binary input file (see map_input_vector), NULL generates input_size samples
+unsigned long long input_seed = INPUT_SEED; // seed of the generated samples
+const char *input_distribution = "uniform"; // distribution of the generated samples (see input_generator.h)
@@ -0,0 +1,477 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <math.h>
+
+// Contiguous span reductions used by the circular buffers.
+// The best instruction set enabled at compile time is picked (AVX2, then SSE2),
+// otherwise a plain scalar loop is used.
+// Define NO_SIMD to force the scalar fallback.
+
+#ifndef NO_SIMD
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  INT32 VALUES                                          *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// Sums n ints starting at p.
+// The lanes are widened to 64 bits, so large windows do not overflow.
+long long simd_sumi(const int *p, size_t n)
+{
+    size_t i = 0;
+    long long acc = 0;
+
+#if defined(SIMD_AVX2)
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(p + i))));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(p + i + 4))));
+    }
+    acc0 = _mm256_add_epi64(acc0, acc1);
+
+    // horizontal sum of the 4 lanes
+    __m128i h = _mm_add_epi64(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+    h = _mm_add_epi64(h, _mm_unpackhi_epi64(h, h));
+    acc = _mm_cvtsi128_si64(h);
+#elif defined(SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4)
+    {
+        // sign extend the 4 ints into two pairs of 64 bits
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i sign = _mm_cmplt_epi32(v, zero);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, sign));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, sign));
+    }
+    acc0 = _mm_add_epi64(acc0, acc1);
+
+    // horizontal sum of the 2 lanes
+    acc0 = _mm_add_epi64(acc0, _mm_unpackhi_epi64(acc0, acc0));
+    acc = _mm_cvtsi128_si64(acc0);
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        acc += p[i];
+    }
+    return acc;
+}
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  DOUBLE VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// Sums n doubles starting at p.
+// Note: the vector paths reassociate the additions, so the last bits may differ
+// from a sequential scalar sum.
+double simd_sumd(const double *p, size_t n)
+{
+    size_t i = 0;
+    double acc = 0.0;
+
+#if defined(SIMD_AVX2)
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(p + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(p + i + 4));
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+
+    // horizontal sum of the 4 lanes
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    h = _mm_add_sd(h, _mm_unpackhi_pd(h, h));
+    acc = _mm_cvtsd_f64(h);
+#elif defined(SIMD_SSE2)
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(p + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(p + i + 2));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+
+    // horizontal sum of the 2 lanes
+    acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+    acc = _mm_cvtsd_f64(acc0);
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        acc += p[i];
+    }
+    return acc;
+}
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  FLOAT  VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// Sums n floats starting at p.
+// Note: the vector paths reassociate the additions, so the last bits may differ
+// from a sequential scalar sum.
+float simd_sumf(const float *p, size_t n)
+{
+    size_t i = 0;
+    float acc = 0.0f;
+
+#if defined(SIMD_AVX2)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(p + i));
+        acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(p + i + 8));
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+
+    // horizontal sum of the 8 lanes
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(1, 1, 1, 1)));
+    acc = _mm_cvtss_f32(h);
+#elif defined(SIMD_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_loadu_ps(p + i));
+        acc1 = _mm_add_ps(acc1, _mm_loadu_ps(p + i + 4));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+
+    // horizontal sum of the 4 lanes
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, _MM_SHUFFLE(1, 1, 1, 1)));
+    acc = _mm_cvtss_f32(acc0);
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        acc += p[i];
+    }
+    return acc;
+}
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  SLIDING HELPERS                                       *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// dst[j] = a[j] - b[j], widened to 64 bits before subtracting
+void simd_diffi(const int *a, const int *b, long long *dst, size_t n)
+{
+    size_t i = 0;
+
+#if defined(SIMD_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i va = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(a + i)));
+        __m256i vb = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(b + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_sub_epi64(va, vb));
+    }
+#elif defined(SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4)
+    {
+        // sign extend the 4 ints of each side into two pairs of 64 bits
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i sa = _mm_cmplt_epi32(va, zero);
+        __m128i sb = _mm_cmplt_epi32(vb, zero);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_sub_epi64(_mm_unpacklo_epi32(va, sa), _mm_unpacklo_epi32(vb, sb)));
+        _mm_storeu_si128((__m128i *)(dst + i + 2), _mm_sub_epi64(_mm_unpackhi_epi32(va, sa), _mm_unpackhi_epi32(vb, sb)));
+    }
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        dst[i] = (long long)a[i] - (long long)b[i];
+    }
+}
+
+// dst[j] = src[j] * factor (e.g. the reciprocal of a divisor)
+void simd_muld(const double *src, double factor, double *dst, size_t n)
+{
+    size_t i = 0;
+
+#if defined(SIMD_AVX2)
+    __m256d vd = _mm256_set1_pd(factor);
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(src + i), vd));
+    }
+#elif defined(SIMD_SSE2)
+    __m128d vd = _mm_set1_pd(factor);
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(src + i), vd));
+    }
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        dst[i] = src[i] * factor;
+    }
+}
+
+// dst[j] = (float)(src[j] * factor)
+void simd_muld_f(const double *src, double factor, float *dst, size_t n)
+{
+    size_t i = 0;
+
+#if defined(SIMD_AVX2)
+    __m256d vd = _mm256_set1_pd(factor);
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(src + i), vd)));
+    }
+#elif defined(SIMD_SSE2)
+    __m128d vd = _mm_set1_pd(factor);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(src + i), vd));
+        __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(src + i + 2), vd));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        dst[i] = (float)(src[i] * factor);
+    }
+}
+
+// sums[j] += src[j] - slot[j], then slot[j] = src[j] (sums are 64 bits)
+void simd_replacei(long long *sums, int *slot, const int *src, size_t n)
+{
+    size_t i = 0;
+
+#if defined(SIMD_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i vnew = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i vold = _mm_loadu_si128((const __m128i *)(slot + i));
+        __m256i diff = _mm256_sub_epi64(_mm256_cvtepi32_epi64(vnew), _mm256_cvtepi32_epi64(vold));
+        __m256i vsum = _mm256_loadu_si256((const __m256i *)(sums + i));
+        _mm256_storeu_si256((__m256i *)(sums + i), _mm256_add_epi64(vsum, diff));
+        _mm_storeu_si128((__m128i *)(slot + i), vnew);
+    }
+#elif defined(SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4)
+    {
+        // sign extend the 4 ints of each side into two pairs of 64 bits
+        __m128i vnew = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i vold = _mm_loadu_si128((const __m128i *)(slot + i));
+        __m128i snew = _mm_cmplt_epi32(vnew, zero);
+        __m128i sold = _mm_cmplt_epi32(vold, zero);
+        __m128i lo = _mm_sub_epi64(_mm_unpacklo_epi32(vnew, snew), _mm_unpacklo_epi32(vold, sold));
+        __m128i hi = _mm_sub_epi64(_mm_unpackhi_epi32(vnew, snew), _mm_unpackhi_epi32(vold, sold));
+        _mm_storeu_si128((__m128i *)(sums + i), _mm_add_epi64(_mm_loadu_si128((const __m128i *)(sums + i)), lo));
+        _mm_storeu_si128((__m128i *)(sums + i + 2), _mm_add_epi64(_mm_loadu_si128((const __m128i *)(sums + i + 2)), hi));
+        _mm_storeu_si128((__m128i *)(slot + i), vnew);
+    }
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        sums[i] += (long long)src[i] - (long long)slot[i];
+        slot[i] = src[i];
+    }
+}
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  DOT PRODUCTS                                          *
+ *                                                                                        *
+ ******************************************************************************************/
+
+// Sum of a[j] * b[j] over n floats (FIR taps against a contiguous span of samples).
+// Note: the vector paths reassociate the additions, like simd_sumf.
+float simd_dotf(const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+    float acc = 0.0f;
+
+#if defined(SIMD_AVX2)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16)
+    {
+#if defined(__FMA__)
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+#else
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+#endif
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+
+    // horizontal sum of the 8 lanes
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(1, 1, 1, 1)));
+    acc = _mm_cvtss_f32(h);
+#elif defined(SIMD_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+
+    // horizontal sum of the 4 lanes
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, _MM_SHUFFLE(1, 1, 1, 1)));
+    acc = _mm_cvtss_f32(acc0);
+#endif
+
+    // remaining elements (or everything on the scalar path)
+    for (; i < n; ++i)
+    {
+        acc += a[i] * b[i];
+    }
+    return acc;
+}
+
+// dst[t] = sum of taps[j] * src[t + j] for j < length (src holds n + length - 1 samples).
+// Tiles of outputs stay in registers while the taps are streamed, so there are no horizontal sums
+// and every sample load feeds several outputs.
+void simd_convf(const float *src, const float *taps, size_t length, float *dst, size_t n)
+{
+    size_t t = 0;
+
+#if defined(SIMD_AVX2)
+    for (; t + 32 <= n; t += 32)
+    {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        for (size_t j = 0; j < length; ++j)
+        {
+            const float *p = src + t + j;
+            __m256 h = _mm256_set1_ps(taps[j]);
+#if defined(__FMA__)
+            acc0 = _mm256_fmadd_ps(h, _mm256_loadu_ps(p), acc0);
+            acc1 = _mm256_fmadd_ps(h, _mm256_loadu_ps(p + 8), acc1);
+            acc2 = _mm256_fmadd_ps(h, _mm256_loadu_ps(p + 16), acc2);
+            acc3 = _mm256_fmadd_ps(h, _mm256_loadu_ps(p + 24), acc3);
+#else
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(h, _mm256_loadu_ps(p)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(h, _mm256_loadu_ps(p + 8)));
+            acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(h, _mm256_loadu_ps(p + 16)));
+            acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(h, _mm256_loadu_ps(p + 24)));
+#endif
+        }
+        _mm256_storeu_ps(dst + t, acc0);
+        _mm256_storeu_ps(dst + t + 8, acc1);
+        _mm256_storeu_ps(dst + t + 16, acc2);
+        _mm256_storeu_ps(dst + t + 24, acc3);
+    }
+    for (; t + 8 <= n; t += 8)
+    {
+        __m256 acc0 = _mm256_setzero_ps();
+        for (size_t j = 0; j < length; ++j)
+        {
+            // same rounding as the 32 wide tiles, so an output does not depend on its tile
+#if defined(__FMA__)
+            acc0 = _mm256_fmadd_ps(_mm256_set1_ps(taps[j]), _mm256_loadu_ps(src + t + j), acc0);
+#else
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_set1_ps(taps[j]), _mm256_loadu_ps(src + t + j)));
+#endif
+        }
+        _mm256_storeu_ps(dst + t, acc0);
+    }
+#elif defined(SIMD_SSE2)
+    for (; t + 16 <= n; t += 16)
+    {
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        __m128 acc2 = _mm_setzero_ps();
+        __m128 acc3 = _mm_setzero_ps();
+        for (size_t j = 0; j < length; ++j)
+        {
+            const float *p = src + t + j;
+            __m128 h = _mm_set1_ps(taps[j]);
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(h, _mm_loadu_ps(p)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(h, _mm_loadu_ps(p + 4)));
+            acc2 = _mm_add_ps(acc2, _mm_mul_ps(h, _mm_loadu_ps(p + 8)));
+            acc3 = _mm_add_ps(acc3, _mm_mul_ps(h, _mm_loadu_ps(p + 12)));
+        }
+        _mm_storeu_ps(dst + t, acc0);
+        _mm_storeu_ps(dst + t + 4, acc1);
+        _mm_storeu_ps(dst + t + 8, acc2);
+        _mm_storeu_ps(dst + t + 12, acc3);
+    }
+#endif
+
+    // remaining outputs (or everything on the scalar path), rounded like the tiles
+    for (; t < n; ++t)
+    {
+        float acc = 0.0f;
+        for (size_t j = 0; j < length; ++j)
+        {
+#if defined(SIMD_AVX2) && defined(__FMA__)
+            acc = fmaf(taps[j], src[t + j], acc);
+#else
+            acc += taps[j] * src[t + j];
+#endif
+        }
+        dst[t] = acc;
+    }
+}
@@ -0,0 +1,134 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// Largest sample magnitude of the input, the sketch is sized for [1, input_magnitude()]
+// (integer samples: every non zero magnitude is at least 1)
+double input_magnitude()
+{
+    int min_value = 0;
+    int max_value = 0;
+    input_vector_bounds(&min_value, &max_value);
+    double magnitude = fmax(fabs((double)min_value), fabs((double)max_value));
+    return (magnitude > 1.0) ? magnitude : 1.0;
+}
+
+// Approximate median and percentiles over the window of the last window_size samples.
+// Removing a sample from the sketch needs its value, which no sketch keeps: the evicted sample
+// is read back from the input vector (window_size samples behind), so no ring is needed.
+int main_sketch()
+{
+    fprintf(stderr, "%s\n", __func__);
+    double median = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    sketchd_t s;                                            // fixed memory quantile sketch
+    sketchd_init(&s, SKETCH_ALPHA, 1.0, input_magnitude()); // sized for the input magnitudes
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        if (i >= window_size)
+        {
+            sketchd_remove(&s, (double)input_vector[i - window_size]); // O(log buckets)
+        }
+        sketchd_add(&s, (double)input_vector[i]); // O(log buckets)
+        median = sketchd_quantile(&s, 0.50);      // O(log buckets)
+        p90 = sketchd_quantile(&s, 0.90);         // O(log buckets)
+        p99 = sketchd_quantile(&s, 0.99);         // O(log buckets)
+        if (verbose)
+        {
+            printf("median: %lf p90: %lf p99: %lf\n", median, p90, p99);
+        }
+    }
+
+    sketchd_free(&s);
+
+    return 0;
+}
+
+// Relative error of an approximation against the exact value (absolute when exact is 0)
+double sketch_error(double approx, double exact)
+{
+    if (exact == 0.0)
+    {
+        return fabs(approx);
+    }
+    return fabs(approx - exact) / fabs(exact);
+}
+
+// Same stream as main_sketch, checked against the exact skiplist (any input range)
+int main_sketch_accuracy()
+{
+    fprintf(stderr, "%s\n", __func__);
+    const double q[3] = {0.50, 0.90, 0.99};
+    double max_error[3] = {0.0, 0.0, 0.0};
+    double sum_error[3] = {0.0, 0.0, 0.0};
+    size_t clamped = 0;
+    sketchd_t s;                                            // fixed memory quantile sketch
+    sketchd_init(&s, SKETCH_ALPHA, 1.0, input_magnitude()); // sized for the input magnitudes
+    bufferd_order_t o;                                      // exact reference
+    bufferd_order_init(&o, window_size);                    // initialize window with window_size as maximum size
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        if (i >= window_size)
+        {
+            sketchd_remove(&s, (double)input_vector[i - window_size]);
+        }
+        sketchd_add(&s, (double)input_vector[i]);
+        bufferd_order_push(&o, (double)input_vector[i]);
+        if (sketchd_clamped(&s) > clamped)
+        {
+            clamped = sketchd_clamped(&s);
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            double error = sketch_error(sketchd_quantile(&s, q[k]), bufferd_order_quantile(&o, q[k]));
+            sum_error[k] += error;
+            if (error > max_error[k])
+            {
+                max_error[k] = error;
+            }
+        }
+    }
+
+    fprintf(stderr, "alpha: %lf sketch memory: %zu bytes\n", SKETCH_ALPHA, sketchd_memory(&s));
+    if (clamped > 0)
+    {
+        fprintf(stderr, "up to %zu window samples above the sketch range, the error bound does not hold\n", clamped);
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+        fprintf(stderr, "q%.2lf max error: %lf mean error: %lf\n", q[k], max_error[k],
+                (input_vector_size > 0) ? sum_error[k] / (double)input_vector_size : 0.0);
+    }
+
+    bufferd_order_free(&o);
+    sketchd_free(&s);
+
+    return 0;
+}
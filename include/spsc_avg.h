@@ -0,0 +1,116 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+// Producer thread: streams input_vector into the ring in BATCH_SIZE blocks
+void *spsc_producer(void *arg)
+{
+    bufferi_spsc_t *q = (bufferi_spsc_t *)arg;
+    size_t i = 0;
+    while (i < input_vector_size)
+    {
+        size_t n = input_vector_size - i;
+        if (n > BATCH_SIZE)
+        {
+            n = BATCH_SIZE;
+        }
+        size_t pushed = bufferi_spsc_push_many(q, input_vector + i, n);
+        if (pushed == 0)
+        {
+            // ring is full, let the consumer run
+            sched_yield();
+        }
+        i += pushed;
+    }
+    return NULL;
+}
+
+// One thread ingests while this one computes the averages, without any lock
+int main_spsc()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int *block = (int *)malloc(BATCH_SIZE * sizeof(int)); // values popped from the ring
+    int *avg = (int *)malloc(BATCH_SIZE * sizeof(int));   // averages of one block
+    static bufferi_spsc_t q;                              // lock-free ring between the threads
+    bufferi_spsc_init(&q, SPSC_CAPACITY, window_size);    // the producer also keeps the window_size running sum
+    bufferi_t b;                                          // buffer struct
+    bufferi_init_pow2(&b, window_size);                   // initialize buffer with window_size as maximum size (mask indexing)
+
+    pthread_t producer;
+    int error = pthread_create(&producer, NULL, spsc_producer, &q);
+    if (error != 0)
+    {
+        // without the producer the consumer would wait forever on an empty ring
+        fprintf(stderr, "spsc: cannot start the producer thread: %s\n", strerror(error));
+        bufferi_free(&b);
+        bufferi_spsc_free(&q);
+        free(avg);
+        free(block);
+        return 1;
+    }
+
+    size_t consumed = 0;
+    while (consumed < input_vector_size)
+    {
+        size_t n = bufferi_spsc_pop_many(&q, block, BATCH_SIZE);
+        if (n == 0)
+        {
+            // ring is empty, let the producer run
+            sched_yield();
+            continue;
+        }
+        bufferi_push_many(&b, block, n, avg); // O(n) for n averages
+        sink_write(&results, avg, n);
+        if (verbose)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                printf("avg: %d\n", avg[j]);
+            }
+        }
+        consumed += n;
+    }
+
+    pthread_join(producer, NULL);
+
+    // lock-free read of the producer running sum, it matches the consumer window
+    long long sum = 0;
+    size_t count = 0;
+    bufferi_spsc_sum(&q, &sum, &count);
+    if (count > 0)
+    {
+        fprintf(stderr, "producer snapshot avg: %lld consumer avg: %d\n", sum / (long long)count, bufferi_mean(&b));
+    }
+
+    bufferi_free(&b);
+    bufferi_spsc_free(&q);
+    free(avg);
+    free(block);
+
+    return 0;
+}
@@ -0,0 +1,327 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <circular_buffer.h>
+
+// Lock-free single producer / single consumer rings.
+// head (consumer) and tail (producer) are free running counters on their own cache lines,
+// published with release stores and read with acquire loads; each side also keeps a cached
+// copy of the other counter so it only touches the shared line when the cached one runs out.
+// Optionally (window > 0) the producer keeps the running sum of the last window pushed values
+// and publishes it as a seqlock protected snapshot any thread can read without locking.
+//
+// SPSC_DEFINE_TRAITS(name, T, K) generates name_t holding T values, the running sum uses the
+// circular_K_* element traits of circular_buffer.h (exact long long sums for integers,
+// compensated double sums for floating point values):
+// name_init/name_clear/name_free, push/push_many (producer), pop/pop_many (consumer) and sum (any thread).
+// SPSC_DEFINE(name, T) uses T as K (bufferi_spsc_t, bufferd_spsc_t and bufferf_spsc_t are these).
+// Comments inside the macros use /* */, a // comment would swallow the line continuation.
+
+#define SPSC_CACHE_LINE 64
+
+#define SPSC_DEFINE_TRAITS(name, T, K)                                                                         \
+typedef struct name##_st                                                                                       \
+{                                                                                                              \
+    /* producer line */                                                                                        \
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t tail;    /* next position to write */                              \
+    size_t head_cache;                               /* last head seen by the producer */                      \
+    circular_##K##_sum_t sum;                        /* running sum of the last window values (producer) */    \
+    circular_##K##_sum_t comp;                       /* running sum compensation, 0 for exact sums */          \
+    size_t count;                                    /* values in the running sum (producer) */                \
+                                                                                                               \
+    /* consumer line */                                                                                        \
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t head;    /* next position to read */                               \
+    size_t tail_cache;                               /* last tail seen by the consumer */                      \
+                                                                                                               \
+    /* snapshot line */                                                                                        \
+    _Alignas(SPSC_CACHE_LINE) atomic_uint seq;       /* snapshot sequence, odd while being written */          \
+    _Atomic circular_##K##_sum_t snap_sum;           /* published running sum */                               \
+    atomic_size_t snap_count;                        /* published running sum size */                          \
+                                                                                                               \
+    /* read only after init */                                                                                 \
+    _Alignas(SPSC_CACHE_LINE) T *data;               /* ring data pointer */                                   \
+    size_t capacity;                                 /* ring size (power of two) */                            \
+    size_t mask;                                     /* capacity - 1 */                                        \
+    size_t window;                                   /* running sum window, 0 disables it */                   \
+} name##_t;                                                                                                    \
+                                                                                                               \
+/* Not thread safe, only call it while neither side is running */                                              \
+void name##_clear(name##_t *q)                                                                                 \
+{                                                                                                              \
+    /* check if ring is not null */                                                                            \
+    CIRCULAR_ASSERT(q != NULL);                                                                                \
+                                                                                                               \
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);                                                  \
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);                                                  \
+    q->head_cache = 0;                                                                                         \
+    q->tail_cache = 0;                                                                                         \
+    q->sum = 0;                                                                                                \
+    q->comp = 0;                                                                                               \
+    q->count = 0;                                                                                              \
+    atomic_store_explicit(&q->seq, 0, memory_order_relaxed);                                                   \
+    atomic_store_explicit(&q->snap_sum, 0, memory_order_relaxed);                                              \
+    atomic_store_explicit(&q->snap_count, 0, memory_order_relaxed);                                            \
+}                                                                                                              \
+                                                                                                               \
+/* capacity is rounded up to a power of two (and to at least window) */                                        \
+void name##_init(name##_t *q, size_t capacity, size_t window)                                                  \
+{                                                                                                              \
+    /* check if ring is not null */                                                                            \
+    CIRCULAR_ASSERT(q != NULL);                                                                                \
+                                                                                                               \
+    if (capacity < window)                                                                                     \
+    {                                                                                                          \
+        capacity = window;                                                                                     \
+    }                                                                                                          \
+    capacity = circular_next_pow2(capacity);                                                                   \
+                                                                                                               \
+    /* allocate the requested size */                                                                          \
+    q->data = (T *)malloc(capacity * sizeof(T));                                                               \
+                                                                                                               \
+    /* check if data allocation was successful */                                                              \
+    if (q->data != NULL)                                                                                       \
+    {                                                                                                          \
+        /* setting up a valid capacity after checking allocation */                                            \
+        q->capacity = capacity;                                                                                \
+        q->mask = capacity - 1;                                                                                \
+        q->window = window;                                                                                    \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        /* setting up a valid capacity after failing allocation */                                             \
+        q->capacity = 0;                                                                                       \
+        q->mask = 0;                                                                                           \
+        q->window = 0;                                                                                         \
+    }                                                                                                          \
+                                                                                                               \
+    /* initializing counters, sums and snapshot as 0 */                                                        \
+    name##_clear(q);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+void name##_free(name##_t *q)                                                                                  \
+{                                                                                                              \
+    /* check if ring is not null and data is allocated before trying to deallocate */                          \
+    CIRCULAR_ASSERT(q != NULL && q->data != NULL);                                                             \
+                                                                                                               \
+    free(q->data);                                                                                             \
+                                                                                                               \
+    /* just making sure the previous pointer is invalid */                                                     \
+    q->data = NULL;                                                                                            \
+    q->capacity = 0;                                                                                           \
+    q->mask = 0;                                                                                               \
+    q->window = 0;                                                                                             \
+    name##_clear(q);                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+/* Producer: adds value to the running sum, evicting the value pushed window positions before. */              \
+/* Must run before value is written at position tail. */                                                       \
+void name##_accumulate(name##_t *q, size_t tail, T value)                                                      \
+{                                                                                                              \
+    if (q->count < q->window)                                                                                  \
+    {                                                                                                          \
+        q->count++;                                                                                            \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        circular_##K##_sub(&q->sum, &q->comp, q->data[(tail - q->window) & q->mask]);                          \
+    }                                                                                                          \
+    circular_##K##_add(&q->sum, &q->comp, value);                                                              \
+}                                                                                                              \
+                                                                                                               \
+/* Producer: publishes the running sum snapshot (seqlock write) */                                             \
+void name##_publish(name##_t *q)                                                                               \
+{                                                                                                              \
+    unsigned s = atomic_load_explicit(&q->seq, memory_order_relaxed);                                          \
+    atomic_store_explicit(&q->seq, s + 1, memory_order_relaxed);                                               \
+    atomic_thread_fence(memory_order_release);                                                                 \
+    atomic_store_explicit(&q->snap_sum, q->sum + q->comp, memory_order_relaxed);                               \
+    atomic_store_explicit(&q->snap_count, q->count, memory_order_relaxed);                                     \
+    atomic_store_explicit(&q->seq, s + 2, memory_order_release);                                               \
+}                                                                                                              \
+                                                                                                               \
+/* Producer: pushes up to n values, returns how many were pushed (less than n when the ring is full) */        \
+size_t name##_push_many(name##_t *q, const T *src, size_t n)                                                   \
+{                                                                                                              \
+    /* check if ring is not null and source is not null */                                                     \
+    CIRCULAR_ASSERT(q != NULL && (src != NULL || n == 0));                                                     \
+                                                                                                               \
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);                                        \
+    size_t room = q->capacity - (tail - q->head_cache);                                                        \
+    if (room < n)                                                                                              \
+    {                                                                                                          \
+        /* refresh the consumer position only when the cached one is not enough */                             \
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);                                  \
+        room = q->capacity - (tail - q->head_cache);                                                           \
+    }                                                                                                          \
+    if (n > room)                                                                                              \
+    {                                                                                                          \
+        n = room;                                                                                              \
+    }                                                                                                          \
+    if (n == 0)                                                                                                \
+    {                                                                                                          \
+        return 0;                                                                                              \
+    }                                                                                                          \
+                                                                                                               \
+    if (q->window > 0)                                                                                         \
+    {                                                                                                          \
+        /* the evicted values are read before their slots can be written again */                              \
+        for (size_t j = 0; j < n; ++j)                                                                         \
+        {                                                                                                      \
+            name##_accumulate(q, tail + j, src[j]);                                                            \
+            q->data[(tail + j) & q->mask] = src[j];                                                            \
+        }                                                                                                      \
+    }                                                                                                          \
+    else                                                                                                       \
+    {                                                                                                          \
+        /* copy in at most two contiguous spans */                                                             \
+        size_t pos = tail & q->mask;                                                                           \
+        size_t first = q->capacity - pos;                                                                      \
+        if (first > n)                                                                                         \
+        {                                                                                                      \
+            first = n;                                                                                         \
+        }                                                                                                      \
+        memcpy(q->data + pos, src, first * sizeof(T));                                                         \
+        memcpy(q->data, src + first, (n - first) * sizeof(T));                                                 \
+    }                                                                                                          \
+                                                                                                               \
+    /* make the values visible to the consumer */                                                              \
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);                                           \
+                                                                                                               \
+    if (q->window > 0)                                                                                         \
+    {                                                                                                          \
+        name##_publish(q);                                                                                     \
+    }                                                                                                          \
+    return n;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* Producer: pushes one value, returns 0 when the ring is full */                                              \
+int name##_push(name##_t *q, T value)                                                                          \
+{                                                                                                              \
+    return (int)name##_push_many(q, &value, 1);                                                                \
+}                                                                                                              \
+                                                                                                               \
+/* Consumer: pops up to n values into dst, returns how many were popped (less than n when empty) */            \
+size_t name##_pop_many(name##_t *q, T *dst, size_t n)                                                          \
+{                                                                                                              \
+    /* check if ring is not null and destination is not null */                                                \
+    CIRCULAR_ASSERT(q != NULL && (dst != NULL || n == 0));                                                     \
+                                                                                                               \
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);                                        \
+    size_t available = q->tail_cache - head;                                                                   \
+    if (available < n)                                                                                         \
+    {                                                                                                          \
+        /* refresh the producer position only when the cached one is not enough */                             \
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);                                  \
+        available = q->tail_cache - head;                                                                      \
+    }                                                                                                          \
+    if (n > available)                                                                                         \
+    {                                                                                                          \
+        n = available;                                                                                         \
+    }                                                                                                          \
+    if (n == 0)                                                                                                \
+    {                                                                                                          \
+        return 0;                                                                                              \
+    }                                                                                                          \
+                                                                                                               \
+    /* copy out in at most two contiguous spans */                                                             \
+    size_t pos = head & q->mask;                                                                               \
+    size_t first = q->capacity - pos;                                                                          \
+    if (first > n)                                                                                             \
+    {                                                                                                          \
+        first = n;                                                                                             \
+    }                                                                                                          \
+    memcpy(dst, q->data + pos, first * sizeof(T));                                                             \
+    memcpy(dst + first, q->data, (n - first) * sizeof(T));                                                     \
+                                                                                                               \
+    /* give the slots back to the producer */                                                                  \
+    atomic_store_explicit(&q->head, head + n, memory_order_release);                                           \
+    return n;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* Consumer: pops one value, returns 0 when the ring is empty */                                               \
+int name##_pop(name##_t *q, T *value)                                                                          \
+{                                                                                                              \
+    return (int)name##_pop_many(q, value, 1);                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* Any thread: consistent snapshot of the running sum of the last window pushed values */                      \
+/* and how many values it holds (seqlock read, retries while the producer is publishing) */                    \
+void name##_sum(name##_t *q, circular_##K##_sum_t *sum, size_t *count)                                         \
+{                                                                                                              \
+    /* check if ring is not null */                                                                            \
+    CIRCULAR_ASSERT(q != NULL);                                                                                \
+                                                                                                               \
+    unsigned s1, s2;                                                                                           \
+    circular_##K##_sum_t snap_sum;                                                                             \
+    size_t snap_count;                                                                                         \
+    do                                                                                                         \
+    {                                                                                                          \
+        s1 = atomic_load_explicit(&q->seq, memory_order_acquire);                                              \
+        snap_sum = atomic_load_explicit(&q->snap_sum, memory_order_relaxed);                                   \
+        snap_count = atomic_load_explicit(&q->snap_count, memory_order_relaxed);                               \
+        atomic_thread_fence(memory_order_acquire);                                                             \
+        s2 = atomic_load_explicit(&q->seq, memory_order_relaxed);                                              \
+    } while (s1 != s2 || (s1 & 1));                                                                            \
+                                                                                                               \
+    if (sum != NULL)                                                                                           \
+    {                                                                                                          \
+        *sum = snap_sum;                                                                                       \
+    }                                                                                                          \
+    if (count != NULL)                                                                                         \
+    {                                                                                                          \
+        *count = snap_count;                                                                                   \
+    }                                                                                                          \
+}
+
+// The element type is also the traits name when it is a single token with circular_T_* traits
+#define SPSC_DEFINE(name, T) SPSC_DEFINE_TRAITS(name, T, T)
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  INT32 VALUES                                          *
+ *                                                                                        *
+ ******************************************************************************************/
+
+SPSC_DEFINE(bufferi_spsc, int)
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  DOUBLE VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+SPSC_DEFINE(bufferd_spsc, double)
+
+
+/******************************************************************************************
+ *                                                                                        *
+ *                                  FLOAT  VALUES                                         *
+ *                                                                                        *
+ ******************************************************************************************/
+
+SPSC_DEFINE(bufferf_spsc, float)
+
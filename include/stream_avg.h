@@ -0,0 +1,94 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <defines.h>
+#include <settings.h>
+#include <data_structures.h>
+
+// Averages the native int32 samples streamed on stdin (e.g. a pipe) until the end of the stream.
+// The memory is two STREAM_CHUNK chunks and the window, whatever the stream length,
+// the reader thread fills one chunk while this one averages the other.
+int main_stream()
+{
+    fprintf(stderr, "%s\n", __func__);
+    int *avg = (int *)malloc(BATCH_SIZE * sizeof(int)); // averages of one block
+    bufferi_t b;                                         // buffer struct
+    bufferi_init_pow2(&b, window_size);                  // initialize buffer with window_size as maximum size (mask indexing)
+    stream_reader_t r;                                   // double-buffered stdin reader
+    if (!stream_reader_init(&r, STDIN_FILENO, STREAM_CHUNK))
+    {
+        if (r.error != 0)
+        {
+            fprintf(stderr, "stream: cannot start the reader thread: %s\n", strerror(r.error));
+        }
+        else
+        {
+            fprintf(stderr, "stream: cannot allocate %d sample chunks\n", STREAM_CHUNK);
+        }
+        bufferi_free(&b);
+        free(avg);
+        return 1;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    const int *chunk;
+    size_t n;
+    while ((chunk = stream_reader_next(&r, &n)) != NULL)
+    {
+        for (size_t i = 0; i < n; i += BATCH_SIZE)
+        {
+            size_t block = (n - i < BATCH_SIZE) ? n - i : BATCH_SIZE;
+            bufferi_push_many(&b, chunk + i, block, avg); // O(n) for n averages
+            sink_write(&results, avg, block);
+            if (verbose)
+            {
+                for (size_t j = 0; j < block; ++j)
+                {
+                    printf("avg: %d\n", avg[j]);
+                }
+            }
+        }
+        stream_reader_release(&r);
+    }
+    stream_reader_free(&r);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - begin.tv_sec) + (double)(end.tv_nsec - begin.tv_nsec) * 1e-9;
+
+    if (r.error != 0)
+    {
+        fprintf(stderr, "stream: %s\n", strerror(r.error));
+    }
+    fprintf(stderr, "stream: %zu samples in %.3lf s, %.0lf samples/s, %.1lf MB/s\n", r.samples, seconds,
+            (seconds > 0.0) ? (double)r.samples / seconds : 0.0,
+            (seconds > 0.0) ? (double)r.samples * sizeof(int) / seconds * 1e-6 : 0.0);
+
+    bufferi_free(&b);
+    free(avg);
+
+    return (r.error != 0);
+}
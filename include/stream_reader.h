@@ -0,0 +1,201 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Double-buffered reader of a stream of native int32 samples (stdin, a pipe, a socket).
+// A reader thread fills one chunk with large read() calls while the consumer averages the other,
+// so the memory is two chunks however long the stream is.
+// A trailing partial sample at the end of the stream is dropped.
+typedef struct stream_reader_st
+{
+    int fd;                 // stream file descriptor
+    int *chunk[2];          // alternating chunks, one is filled while the other is consumed
+    size_t count[2];        // samples in each filled chunk
+    int full[2];            // chunk k is filled and not yet released by the consumer
+    int last[2];            // chunk k ends the stream (end of file or error)
+    int finished;           // the consumer released the last chunk
+    int error;              // errno of a failed read(), 0 otherwise
+    size_t chunk_size;      // samples per chunk
+    size_t next;            // next chunk for the consumer
+    size_t samples;         // samples read so far
+    pthread_mutex_t lock;   // protects count, full and last
+    pthread_cond_t changed; // signaled when a chunk is filled or released
+    pthread_t thread;       // reader thread
+} stream_reader_t;
+
+// Reads until the chunk is full or the stream ends, returns the bytes read
+size_t stream_reader_fill(stream_reader_t *r, char *dst, size_t bytes, int *end)
+{
+    size_t filled = 0;
+    while (filled < bytes)
+    {
+        ssize_t n = read(r->fd, dst + filled, bytes - filled);
+        if (n > 0)
+        {
+            filled += (size_t)n;
+        }
+        else if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            // end of stream or error
+            if (n < 0)
+            {
+                r->error = errno;
+            }
+            *end = 1;
+            break;
+        }
+    }
+    return filled;
+}
+
+void *stream_reader_run(void *arg)
+{
+    stream_reader_t *r = (stream_reader_t *)arg;
+    int end = 0;
+    for (size_t k = 0; !end; k ^= 1)
+    {
+        // wait for the consumer to release this chunk
+        pthread_mutex_lock(&r->lock);
+        while (r->full[k])
+        {
+            pthread_cond_wait(&r->changed, &r->lock);
+        }
+        pthread_mutex_unlock(&r->lock);
+
+        // the chunk is only touched by this thread until it is marked full
+        size_t bytes = stream_reader_fill(r, (char *)r->chunk[k], r->chunk_size * sizeof(int), &end);
+
+        pthread_mutex_lock(&r->lock);
+        r->count[k] = bytes / sizeof(int);
+        r->samples += r->count[k];
+        r->full[k] = 1;
+        r->last[k] = end;
+        pthread_cond_broadcast(&r->changed);
+        pthread_mutex_unlock(&r->lock);
+    }
+    return NULL;
+}
+
+// Allocates the two chunks and starts the reader thread, returns 0 on failure
+// (error is then the pthread_create error, or 0 when the chunks cannot be allocated)
+int stream_reader_init(stream_reader_t *r, int fd, size_t chunk_size)
+{
+#ifndef NO_ASSERT
+    // check if reader is not null
+    assert(r != NULL);
+#endif
+
+    r->fd = fd;
+    r->chunk_size = (chunk_size > 0) ? chunk_size : 1;
+    r->chunk[0] = (int *)malloc(r->chunk_size * sizeof(int));
+    r->chunk[1] = (int *)malloc(r->chunk_size * sizeof(int));
+    r->count[0] = r->count[1] = 0;
+    r->full[0] = r->full[1] = 0;
+    r->last[0] = r->last[1] = 0;
+    r->finished = 0;
+    r->error = 0;
+    r->next = 0;
+    r->samples = 0;
+    if (r->chunk[0] == NULL || r->chunk[1] == NULL)
+    {
+        free(r->chunk[0]);
+        free(r->chunk[1]);
+        r->chunk[0] = r->chunk[1] = NULL;
+        return 0;
+    }
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->changed, NULL);
+    int error = pthread_create(&r->thread, NULL, stream_reader_run, r);
+    if (error != 0)
+    {
+        // no chunk would ever be filled
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->changed);
+        free(r->chunk[0]);
+        free(r->chunk[1]);
+        r->chunk[0] = r->chunk[1] = NULL;
+        r->error = error;
+        return 0;
+    }
+    return 1;
+}
+
+// Waits for the next filled chunk and returns it with its sample count in n (0 is possible),
+// NULL once the last chunk was released. The chunk stays valid until stream_reader_release.
+const int *stream_reader_next(stream_reader_t *r, size_t *n)
+{
+    *n = 0;
+    if (r->finished)
+    {
+        return NULL;
+    }
+
+    size_t k = r->next;
+    pthread_mutex_lock(&r->lock);
+    while (!r->full[k])
+    {
+        pthread_cond_wait(&r->changed, &r->lock);
+    }
+    *n = r->count[k];
+    pthread_mutex_unlock(&r->lock);
+
+    return r->chunk[k];
+}
+
+// Gives the chunk returned by stream_reader_next back to the reader thread
+void stream_reader_release(stream_reader_t *r)
+{
+    size_t k = r->next;
+    pthread_mutex_lock(&r->lock);
+    r->finished = r->last[k];
+    r->full[k] = 0;
+    pthread_cond_broadcast(&r->changed);
+    pthread_mutex_unlock(&r->lock);
+    r->next ^= 1;
+}
+
+// Joins the reader thread (the stream must have been consumed up to its last chunk) and frees the chunks
+void stream_reader_free(stream_reader_t *r)
+{
+#ifndef NO_ASSERT
+    // check if reader is not null
+    assert(r != NULL);
+#endif
+
+    pthread_join(r->thread, NULL);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->changed);
+    free(r->chunk[0]);
+    free(r->chunk[1]);
+    r->chunk[0] = r->chunk[1] = NULL;
+}
@@ -0,0 +1,89 @@
+// MIT License
+
+// Copyright (c) 2023 Lucas Oliveira Maggi
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+#include <defines.h>
+#include <settings.h>
+#include <alloc_vec.h>
+#include <data_structures.h>
+
+int main_variance()
+{
+    fprintf(stderr, "%s\n", __func__);
+    double avg = 0.0;
+    double variance = 0.0;
+    bufferd_stats_t s;                   // window with incremental mean/variance
+    bufferd_stats_init(&s, window_size); // initialize window with window_size as maximum size
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        bufferd_stats_push(&s, (double)input_vector[i], &avg, &variance); // O(1)
+        if (verbose)
+        {
+            bufferd_print(&s.window);
+            printf("avg: %lf stddev: %lf\n", avg, sqrt(variance));
+        }
+    }
+
+    bufferd_stats_free(&s);
+
+    return 0;
+}
+
+// Reference implementation, a second pass over the window for every sample
+int main_variance_naive()
+{
+    fprintf(stderr, "%s\n", __func__);
+    double avg = 0.0;
+    double variance = 0.0;
+    bufferd_t b;                        // buffer struct
+    bufferd_init_pow2(&b, window_size); // initialize buffer with window_size as maximum size (mask indexing)
+
+    for (size_t i = 0; i < input_vector_size; ++i)
+    {
+        if (b.size < b.max_size)
+        {
+            bufferd_push_back(&b, (double)input_vector[i]); // O(1)
+        }
+        else
+        {
+            bufferd_push_and_pop(&b, (double)input_vector[i], NULL); // O(1)
+        }
+
+        bufferd_avgd(&b, &avg); // O(n)
+        variance = 0.0;
+        for (size_t p = 0; p < b.size; ++p) // O(n)
+        {
+            double d = bufferd_get(&b, p) - avg;
+            variance += d * d;
+        }
+        variance /= (double)b.size;
+        if (verbose)
+        {
+            bufferd_print(&b);
+            printf("avg: %lf stddev: %lf\n", avg, sqrt(variance));
+        }
+    }
+
+    bufferd_free(&b);
+
+    return 0;
+}
@@ -21,17 +21,18 @@
 // SOFTWARE.
 #pragma once
 #include <defines.h>
+#include <settings.h>
 #include <alloc_vec.h>
 #include <data_structures.h>
 
 int main_vector()
 {
-    printf("%s\n", __func__);
+    fprintf(stderr, "%s\n", __func__);
     int avg = 0;
-    bufferi_t b;                   // buffer struct
-    bufferi_init(&b, WINDOW_SIZE); // initialize buffer with WINDOW_SIZE as maximum size
+    bufferi_t b;                        // buffer struct
+    bufferi_init_pow2(&b, window_size); // initialize buffer with window_size as maximum size (mask indexing)
 
-    for (int i = 0; i < input_vector_size; ++i)
+    for (size_t i = 0; i < input_vector_size; ++i)
     {
         if (b.size < b.max_size)
         {
@@ -42,10 +43,12 @@ int main_vector()
             bufferi_push_and_pop(&b, input_vector[i], NULL); // O(1)
         }
         bufferi_avgi(&b, &avg); // O(n)
-#ifndef BENCHMARK
-        bufferi_print(&b);
-        printf("avg: %d\n", avg);
-#endif
+        sink_put(&results, avg);
+        if (verbose)
+        {
+            bufferi_print(&b);
+            printf("avg: %d\n", avg);
+        }
     }
 
     bufferi_free(&b);
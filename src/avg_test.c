@@ -21,41 +21,97 @@
 // SOFTWARE.
 #include <stdio.h>
 #include <defines.h>
+#include <settings.h>
 #include <avg_methods.h>
-#include <time.h>
+#include <bench.h>
 
-int main()
+int main(int argc, char **argv)
 {
-    printf("Hello World!\n");
-
-#ifdef BENCHMARK
-    // check the defines.h file to see what is the allocation size
-    // note: this will allocate the BENCHMARK_SIZE*sizeof(int) in memory
-    init_input_vector(BENCHMARK_SIZE);
-#else
-    init_input_vector(BSZM * 4);
-    print_input_vector();
-#endif
-
-    time_t t_begin;
-    time_t t_end;
-    double secs_iterative, secs_vector;
-
-    time(&t_begin);
-    main_iterative();
-    time(&t_end);
-    secs_iterative = difftime(t_end, t_begin);
-    printf("iterative averaging: %.3lf\n", secs_iterative);
-
-    puts("\n");
-
-    time(&t_begin);
-    main_vector();
-    time(&t_end);
-    secs_vector = difftime(t_end, t_begin);
-    printf("vector averaging: %.3lf\n", secs_vector);
+    bench_options_t options;
+    if (!bench_parse(argc, argv, &options))
+    {
+        bench_usage(argv[0]);
+        return 1;
+    }
+
+    if (options.stream)
+    {
+        // live input, nothing is preloaded (and no array to keep the averages in)
+        if (options.output != NULL && strcmp(options.output, "array") == 0)
+        {
+            options.output = NULL;
+        }
+        if (!bench_open_sink(&options))
+        {
+            return 1;
+        }
+        sink_begin(&results);
+        int status = main_stream();
+        sink_end(&results);
+        bench_close_sink(&options);
+        return status;
+    }
+
+    bench_open_counters(&options);
+
+    if (input_path != NULL)
+    {
+        // int32 files are used in place, nothing is read until a method runs
+        if (!map_input_vector(input_path))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        // note: this will allocate input_size*sizeof(int) in memory
+        if (!init_input_vector(input_size))
+        {
+            return 1;
+        }
+    }
+    if (verbose)
+    {
+        print_input_vector();
+    }
+
+    if (!bench_open_sink(&options))
+    {
+        free_input_vector();
+        return 1;
+    }
+
+    size_t selected = 0;
+    bench_result_t result;
+    bench_report_header(&options);
+    for (size_t m = 0; m < BENCH_METHODS; ++m)
+    {
+        if (bench_selected(options.methods, bench_methods[m].name))
+        {
+            if (!bench_run(&bench_methods[m], &options, &result))
+            {
+                bench_close_counters(&options);
+                bench_close_sink(&options);
+                free_input_vector();
+                bench_usage(argv[0]);
+                return 1;
+            }
+            bench_report(&options, &result, selected == 0);
+            selected++;
+        }
+    }
+    bench_report_footer(&options);
+    bench_close_counters(&options);
+    bench_close_sink(&options);
 
     free_input_vector();
 
+    if (selected == 0)
+    {
+        fprintf(stderr, "no method matches \"%s\"\n", options.methods);
+        bench_usage(argv[0]);
+        return 1;
+    }
+
     return 0;
 }
\ No newline at end of file